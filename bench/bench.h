@@ -0,0 +1,61 @@
+#ifndef BENCH_H
+#define BENCH_H
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "../src/clock.h"
+#include "../src/invaders.h"
+
+// Environment variable naming the file benchRecord() appends results to
+#define BENCH_JSON_VARIABLE "BENCH_JSON"
+
+// Concatenates the given files into the buffer, returns the number of bytes read or -1 on failure
+static inline long benchLoadFiles(int fileCount, char **fileNames, uint8_t *buffer, size_t capacity) {
+    size_t size = 0;
+    for (int i = 0; i < fileCount; i++) {
+        FILE *file = fopen(fileNames[i], "rb");
+        if (file == NULL) {
+            perror(fileNames[i]);
+            return -1;
+        }
+        size += fread(buffer + size, 1, capacity - size, file);
+        fclose(file);
+    }
+    return (long) size;
+}
+
+// Resets the board and loads the ROM set of the manifest into it. Returns 0 on success, -1 on failure.
+static inline int benchLoadInvaders(SpaceInvaders *invaders, const char *manifest) {
+    invadersInit(invaders);
+    return loadRomSet(manifest, invaders->machine.memory) < 0 ? -1 : 0;
+}
+
+// Runs the board for the given number of emulated seconds with the runner set on its machine and returns how many
+// seconds that took
+static inline double benchRunInvaders(SpaceInvaders *invaders, int seconds) {
+    double start = clockNow();
+    machineRunFrames(&invaders->machine, (uint64_t) seconds * INVADERS_FRAME_RATE);
+    return clockNow() - start;
+}
+
+// Appends a result as one JSON object per line to the file named by $BENCH_JSON, if it is set. The benchmark and
+// metric name the value for bench_compare, which flags it when it gets worse by more than a threshold.
+static inline void benchRecord(const char *benchmark, const char *metric, double value, const char *unit,
+                               int higherIsBetter) {
+    const char *fileName = getenv(BENCH_JSON_VARIABLE);
+    if (fileName == NULL || fileName[0] == '\0') {
+        return;
+    }
+    FILE *file = fopen(fileName, "a");
+    if (file == NULL) {
+        perror(fileName);
+        return;
+    }
+    fprintf(file, "{\"benchmark\": \"%s\", \"metric\": \"%s\", \"value\": %.6g, \"unit\": \"%s\", "
+                  "\"better\": \"%s\"}\n", benchmark, metric, value, unit, higherIsBetter ? "higher" : "lower");
+    fclose(file);
+}
+
+#endif
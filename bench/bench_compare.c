@@ -0,0 +1,127 @@
+// Compares two sets of benchmark results written by benchRecord(), e.g. the bench.json of a CI run against the one
+// of the main branch. Fails when a result got worse than the baseline by more than the threshold.
+// USAGE: bench_compare [-t PERCENT] BASELINE CURRENT
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#define USAGE "USAGE: bench_compare [-t PERCENT] BASELINE CURRENT\n"
+
+#define MAX_RESULTS 256
+#define MAX_NAME_LENGTH 64
+
+typedef struct {
+    char benchmark[MAX_NAME_LENGTH];
+    char metric[MAX_NAME_LENGTH];
+    double value;
+    char unit[MAX_NAME_LENGTH];
+    int higherIsBetter;
+} Result;
+
+// Reads every result object of the file, whether it is a JSON array or holds one object per line.
+// Returns the number of results, -1 on failure.
+static int readResults(const char *fileName, Result *results) {
+    FILE *file = fopen(fileName, "rb");
+    if (file == NULL) {
+        perror(fileName);
+        return -1;
+    }
+    fseek(file, 0, SEEK_END);
+    long size = ftell(file);
+    rewind(file);
+    char *text = size >= 0 ? malloc((size_t) size + 1) : NULL;
+    if (text == NULL) {
+        fprintf(stderr, "Cannot read %s\n", fileName);
+        fclose(file);
+        return -1;
+    }
+    text[fread(text, 1, (size_t) size, file)] = '\0';
+    fclose(file);
+
+    int count = 0;
+    for (char *object = strstr(text, "{\"benchmark\""); object != NULL && count < MAX_RESULTS;
+         object = strstr(object + 1, "{\"benchmark\"")) {
+        Result *result = &results[count];
+        char better[8];
+        if (sscanf(object, "{\"benchmark\": \"%63[^\"]\", \"metric\": \"%63[^\"]\", \"value\": %lf, "
+                           "\"unit\": \"%63[^\"]\", \"better\": \"%7[^\"]\"", result->benchmark, result->metric,
+                   &result->value, result->unit, better) != 5) {
+            fprintf(stderr, "%s: malformed result at byte %ld\n", fileName, (long) (object - text));
+            free(text);
+            return -1;
+        }
+        result->higherIsBetter = strcmp(better, "higher") == 0;
+        count++;
+    }
+    free(text);
+    return count;
+}
+
+static const Result *findResult(const Result *results, int count, const Result *key) {
+    for (int i = 0; i < count; i++) {
+        if (strcmp(results[i].benchmark, key->benchmark) == 0 && strcmp(results[i].metric, key->metric) == 0) {
+            return &results[i];
+        }
+    }
+    return NULL;
+}
+
+int main(int argc, char **argv) {
+    double threshold = 10.0;
+    int option;
+    while ((option = getopt(argc, argv, "t:")) != -1) {
+        switch (option) {
+            case 't':
+                threshold = atof(optarg);
+                break;
+            default:
+                fprintf(stderr, USAGE);
+                return 2;
+        }
+    }
+    if (optind != argc - 2 || threshold < 0) {
+        fprintf(stderr, USAGE);
+        return 2;
+    }
+
+    static Result baseline[MAX_RESULTS], current[MAX_RESULTS];
+    int baselineCount = readResults(argv[optind], baseline);
+    int currentCount = readResults(argv[optind + 1], current);
+    if (baselineCount < 0 || currentCount < 0) {
+        return 2;
+    }
+
+    int regressions = 0;
+    for (int i = 0; i < currentCount; i++) {
+        const Result *result = &current[i];
+        const Result *base = findResult(baseline, baselineCount, result);
+        if (base == NULL || base->value == 0) {
+            printf("%-12s %-20s %12.3f %-16s new\n", result->benchmark, result->metric, result->value, result->unit);
+            continue;
+        }
+        // Positive when the result got better, whichever direction that is
+        double change = 100.0 * (result->value - base->value) / base->value;
+        if (!result->higherIsBetter) {
+            change = -change;
+        }
+        int regressed = change < -threshold;
+        regressions += regressed;
+        printf("%-12s %-20s %12.3f %-16s %+7.1f%%%s\n", result->benchmark, result->metric, result->value,
+               result->unit, change, regressed ? "  REGRESSION" : "");
+    }
+    for (int i = 0; i < baselineCount; i++) {
+        if (findResult(current, currentCount, &baseline[i]) == NULL) {
+            printf("%-12s %-20s %12s %-16s missing\n", baseline[i].benchmark, baseline[i].metric, "",
+                   baseline[i].unit);
+        }
+    }
+
+    if (regressions > 0) {
+        fflush(stdout);
+        fprintf(stderr, "%d results got more than %.1f%% worse than the baseline\n", regressions, threshold);
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,67 @@
+// Runs Space Invaders headless on the interpreter and on the block cache, checks both end in the same state and
+// compares their speed.
+// USAGE: blockcache_bench MANIFEST [SECONDS] (e.g. rom/spaceinvaders/manifest)
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "bench.h"
+#include "../src/blockcache.h"
+
+static uint64_t runCache(void *context, uint64_t cycles) {
+    return blockCacheRun(context, cycles);
+}
+
+static double run(const char *name, SpaceInvaders *invaders, int seconds) {
+    double elapsed = benchRunInvaders(invaders, seconds);
+
+    const Cpu *cpu = &invaders->machine.cpu;
+    printf("%-12s %8.1f MIPS %8.1f MHz\n", name, (double) cpu->instructions / elapsed / 1e6,
+           (double) cpu->cycles / elapsed / 1e6);
+    benchRecord("blockcache", name, (double) cpu->instructions / elapsed / 1e6, "MIPS", 1);
+    return elapsed;
+}
+
+int main(int argc, char **argv) {
+    if (argc < 2) {
+        fprintf(stderr, "USAGE: blockcache_bench MANIFEST [SECONDS]\n");
+        return 1;
+    }
+    int seconds = argc > 2 ? atoi(argv[2]) : 60;
+
+    static SpaceInvaders interpreterBoard;
+    if (benchLoadInvaders(&interpreterBoard, argv[1]) != 0) {
+        return 1;
+    }
+    double interpreterElapsed = run("interpreter", &interpreterBoard, seconds);
+
+    static SpaceInvaders cacheBoard;
+    BlockCache cache;
+    if (benchLoadInvaders(&cacheBoard, argv[1]) != 0) {
+        return 1;
+    }
+    if (blockCacheInit(&cache, &cacheBoard.machine.cpu) < 0) {
+        fprintf(stderr, "Failed to allocate the block cache\n");
+        return 1;
+    }
+    machineSetRunner(&cacheBoard.machine, runCache, &cache);
+    double cacheElapsed = run("block cache", &cacheBoard, seconds);
+    printf("speedup      %8.2fx\n", interpreterElapsed / cacheElapsed);
+    printf("hit rate     %8.2f%% of %llu lookups, %llu invalidations\n",
+           cache.lookups ? 100.0 * (double) cache.hits / (double) cache.lookups : 0.0,
+           (unsigned long long) cache.lookups, (unsigned long long) cache.invalidations);
+    machineSetRunner(&cacheBoard.machine, NULL, NULL);
+    blockCacheFree(&cache);
+
+    const Cpu *interpreterCpu = &interpreterBoard.machine.cpu;
+    const Cpu *cacheCpu = &cacheBoard.machine.cpu;
+    if (cacheCpu->cycles != interpreterCpu->cycles || cacheCpu->instructions != interpreterCpu->instructions ||
+        cacheCpu->pc != interpreterCpu->pc || cacheCpu->flags != interpreterCpu->flags ||
+        memcmp(cacheCpu->registers, interpreterCpu->registers, 8) != 0 ||
+        memcmp(cacheCpu->memory, interpreterCpu->memory, MEMORY_SIZE) != 0) {
+        fprintf(stderr, "The interpreter and the block cache ended in different states\n");
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,59 @@
+// Runs CP/M CPU diagnostics such as TST8080, 8080PRE, CPUTEST and 8080EXM one after another on the interpreter,
+// fails unless every one passes, and reports the speed it ran each at.
+// USAGE: conformance_bench PROGRAM...
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "bench.h"
+#include "../src/cpm.h"
+
+// 8080EXM, the longest of the diagnostics, takes about 24 billion cycles
+#define MAX_CYCLES 100000000000ULL
+
+static const char *baseName(const char *fileName) {
+    const char *slash = strrchr(fileName, '/');
+    return slash == NULL ? fileName : slash + 1;
+}
+
+int main(int argc, char **argv) {
+    if (argc < 2) {
+        fprintf(stderr, "USAGE: conformance_bench PROGRAM...\n");
+        return 1;
+    }
+
+    CpmSystem *system = malloc(sizeof(CpmSystem));
+    if (system == NULL) {
+        fprintf(stderr, "Cannot allocate the system\n");
+        return 1;
+    }
+    int failures = 0;
+    for (int i = 1; i < argc; i++) {
+        if (cpmInit(system, argv[i]) != 0) {
+            failures++;
+            continue;
+        }
+        double start = clockNow();
+        cpmRun(system, MAX_CYCLES);
+        double elapsed = clockNow() - start;
+
+        uint64_t instructions = system->machine.cpu.instructions;
+        if (!cpmPassed(system)) {
+            fprintf(stderr, "%s failed:\n%s\n", argv[i], system->output);
+            failures++;
+            continue;
+        }
+        double mips = (double) instructions / elapsed / 1e6;
+        printf("%-24s %14llu instructions %9.3f s %8.1f MIPS\n", baseName(argv[i]), (unsigned long long) instructions,
+               elapsed, mips);
+        benchRecord("conformance", baseName(argv[i]), mips, "MIPS", 1);
+    }
+    free(system);
+
+    if (failures != 0) {
+        fprintf(stderr, "%d of %d programs failed\n", failures, argc - 1);
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,65 @@
+// Runs Space Invaders headless on both interpreter dispatch loops and compares their speed with each other
+// and with the 2 MHz of the arcade CPU.
+// USAGE: cpu_bench MANIFEST [SECONDS] (e.g. rom/spaceinvaders/manifest)
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "bench.h"
+
+static uint64_t runSwitch(void *context, uint64_t cycles) {
+    return cpuRunSwitch(context, cycles);
+}
+
+#if CPU_THREADED_DISPATCH
+static uint64_t runThreaded(void *context, uint64_t cycles) {
+    return cpuRunThreaded(context, cycles);
+}
+#endif
+
+static double run(const char *name, SpaceInvaders *invaders, int seconds, CpuRunner runner) {
+    Cpu *cpu = &invaders->machine.cpu;
+    machineSetRunner(&invaders->machine, runner, cpu);
+    double elapsed = benchRunInvaders(invaders, seconds);
+
+    double emulatedSeconds = (double) cpu->cycles / INVADERS_CLOCK_RATE;
+    printf("%-9s %8.1f MIPS %8.1f MHz %6.0fx real time\n", name, (double) cpu->instructions / elapsed / 1e6,
+           (double) cpu->cycles / elapsed / 1e6, emulatedSeconds / elapsed);
+    benchRecord("cpu", name, (double) cpu->instructions / elapsed / 1e6, "MIPS", 1);
+    return elapsed;
+}
+
+int main(int argc, char **argv) {
+    if (argc < 2) {
+        fprintf(stderr, "USAGE: cpu_bench MANIFEST [SECONDS]\n");
+        return 1;
+    }
+    int seconds = argc > 2 ? atoi(argv[2]) : 60;
+
+    static SpaceInvaders switchBoard;
+    if (benchLoadInvaders(&switchBoard, argv[1]) != 0) {
+        return 1;
+    }
+    double switchElapsed = run("switch", &switchBoard, seconds, runSwitch);
+
+#if CPU_THREADED_DISPATCH
+    static SpaceInvaders threadedBoard;
+    if (benchLoadInvaders(&threadedBoard, argv[1]) != 0) {
+        return 1;
+    }
+    double threadedElapsed = run("threaded", &threadedBoard, seconds, runThreaded);
+    printf("speedup   %8.2fx\n", switchElapsed / threadedElapsed);
+
+    const Cpu *switchCpu = &switchBoard.machine.cpu;
+    const Cpu *threadedCpu = &threadedBoard.machine.cpu;
+    if (threadedCpu->cycles != switchCpu->cycles || threadedCpu->pc != switchCpu->pc ||
+        memcmp(threadedCpu->memory, switchCpu->memory, MEMORY_SIZE) != 0) {
+        fprintf(stderr, "The dispatch loops ended in different states\n");
+        return 1;
+    }
+#else
+    (void) switchElapsed;
+#endif
+    return 0;
+}
@@ -0,0 +1,178 @@
+#pragma clang diagnostic push
+#pragma ide diagnostic ignored "hicpp-signed-bitwise"
+
+// Compares the opcode descriptor table against the if/else chain the disassembler used to decode with.
+// USAGE: decode_bench FILE... (e.g. rom/spaceinvaders/invaders.h invaders.g invaders.f invaders.e)
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "bench.h"
+#include "../src/opcodes.h"
+
+#define ITERATIONS 2000
+
+// The decoding chain from main() before the opcode table, reduced to mnemonic and length. Like the original it
+// has no SPHL and treats 0xF9 as invalid.
+static int legacyDecode(int opCode, const char **mnemonic) {
+    if (opCode == 0x00) { *mnemonic = "NOP"; return 1; }
+    else if ((opCode & 0xCF) == 0x01) { *mnemonic = "LXI"; return 3; }
+    else if ((opCode & 0xEF) == 0x02) { *mnemonic = "STAX"; return 1; }
+    else if ((opCode & 0xCF) == 0x03) { *mnemonic = "INX"; return 1; }
+    else if ((opCode & 0xC7) == 0x04) { *mnemonic = "INR"; return 1; }
+    else if ((opCode & 0xC7) == 0x05) { *mnemonic = "DCR"; return 1; }
+    else if ((opCode & 0xC7) == 0x06) { *mnemonic = "MVI"; return 2; }
+    else if (opCode == 0x07) { *mnemonic = "RLC"; return 1; }
+    else if ((opCode & 0xCF) == 0x09) { *mnemonic = "DAD"; return 1; }
+    else if ((opCode & 0xEF) == 0x0A) { *mnemonic = "LDAX"; return 1; }
+    else if ((opCode & 0xCF) == 0x0B) { *mnemonic = "DCX"; return 1; }
+    else if (opCode == 0x0F) { *mnemonic = "RRC"; return 1; }
+    else if (opCode == 0x17) { *mnemonic = "RAL"; return 1; }
+    else if (opCode == 0x1F) { *mnemonic = "RAR"; return 1; }
+    else if (opCode == 0x22) { *mnemonic = "SHLD"; return 3; }
+    else if (opCode == 0x27) { *mnemonic = "DAA"; return 1; }
+    else if (opCode == 0x2A) { *mnemonic = "LHLD"; return 3; }
+    else if (opCode == 0x2F) { *mnemonic = "CMA"; return 1; }
+    else if (opCode == 0x32) { *mnemonic = "STA"; return 3; }
+    else if (opCode == 0x37) { *mnemonic = "STC"; return 1; }
+    else if (opCode == 0x3A) { *mnemonic = "LDA"; return 3; }
+    else if (opCode == 0x3F) { *mnemonic = "CMC"; return 1; }
+    else if (opCode == 0x76) { *mnemonic = "HLT"; return 1; }
+    else if ((opCode & 0xC0) == 0x40) { *mnemonic = "MOV"; return 1; }
+    else if ((opCode & 0xF8) == 0x80) { *mnemonic = "ADD"; return 1; }
+    else if ((opCode & 0xF8) == 0x88) { *mnemonic = "ADC"; return 1; }
+    else if ((opCode & 0xF8) == 0x90) { *mnemonic = "SUB"; return 1; }
+    else if ((opCode & 0xF8) == 0x98) { *mnemonic = "SBB"; return 1; }
+    else if ((opCode & 0xF8) == 0xA0) { *mnemonic = "ANA"; return 1; }
+    else if ((opCode & 0xF8) == 0xA8) { *mnemonic = "XRA"; return 1; }
+    else if ((opCode & 0xF8) == 0xB0) { *mnemonic = "ORA"; return 1; }
+    else if ((opCode & 0xF8) == 0xB8) { *mnemonic = "CMP"; return 1; }
+    else if (opCode == 0xC0) { *mnemonic = "RNZ"; return 1; }
+    else if ((opCode & 0xCF) == 0xC1) { *mnemonic = "POP"; return 1; }
+    else if (opCode == 0xC2) { *mnemonic = "JNZ"; return 3; }
+    else if (opCode == 0xC3) { *mnemonic = "JMP"; return 3; }
+    else if (opCode == 0xC4) { *mnemonic = "CNZ"; return 3; }
+    else if ((opCode & 0xCF) == 0xC5) { *mnemonic = "PUSH"; return 1; }
+    else if (opCode == 0xC6) { *mnemonic = "ADI"; return 2; }
+    else if ((opCode & 0xC7) == 0xC7) { *mnemonic = "RST"; return 1; }
+    else if (opCode == 0xC8) { *mnemonic = "RZ"; return 1; }
+    else if (opCode == 0xC9) { *mnemonic = "RET"; return 1; }
+    else if (opCode == 0xCA) { *mnemonic = "JZ"; return 3; }
+    else if (opCode == 0xCC) { *mnemonic = "CZ"; return 3; }
+    else if (opCode == 0xCD) { *mnemonic = "CALL"; return 3; }
+    else if (opCode == 0xCE) { *mnemonic = "ACI"; return 2; }
+    else if (opCode == 0xD0) { *mnemonic = "RNC"; return 1; }
+    else if (opCode == 0xD2) { *mnemonic = "JNC"; return 3; }
+    else if (opCode == 0xD3) { *mnemonic = "OUT"; return 2; }
+    else if (opCode == 0xD4) { *mnemonic = "CNC"; return 3; }
+    else if (opCode == 0xD6) { *mnemonic = "SUI"; return 2; }
+    else if (opCode == 0xD8) { *mnemonic = "RC"; return 1; }
+    else if (opCode == 0xDA) { *mnemonic = "JC"; return 3; }
+    else if (opCode == 0xDB) { *mnemonic = "IN"; return 2; }
+    else if (opCode == 0xDC) { *mnemonic = "CC"; return 3; }
+    else if (opCode == 0xDE) { *mnemonic = "SBI"; return 2; }
+    else if (opCode == 0xE0) { *mnemonic = "RPO"; return 1; }
+    else if (opCode == 0xE2) { *mnemonic = "JPO"; return 3; }
+    else if (opCode == 0xE3) { *mnemonic = "XTHL"; return 1; }
+    else if (opCode == 0xE4) { *mnemonic = "CPO"; return 3; }
+    else if (opCode == 0xE6) { *mnemonic = "ANI"; return 2; }
+    else if (opCode == 0xE8) { *mnemonic = "RPE"; return 1; }
+    else if (opCode == 0xE9) { *mnemonic = "PCHL"; return 1; }
+    else if (opCode == 0xEA) { *mnemonic = "JPE"; return 3; }
+    else if (opCode == 0xEB) { *mnemonic = "XCHG"; return 1; }
+    else if (opCode == 0xEC) { *mnemonic = "CPE"; return 3; }
+    else if (opCode == 0xEE) { *mnemonic = "XRI"; return 2; }
+    else if (opCode == 0xF0) { *mnemonic = "RP"; return 1; }
+    else if (opCode == 0xF2) { *mnemonic = "JP"; return 3; }
+    else if (opCode == 0xF3) { *mnemonic = "DI"; return 1; }
+    else if (opCode == 0xF4) { *mnemonic = "CP"; return 3; }
+    else if (opCode == 0xF6) { *mnemonic = "ORI"; return 2; }
+    else if (opCode == 0xF8) { *mnemonic = "RM"; return 1; }
+    else if (opCode == 0xFA) { *mnemonic = "JM"; return 3; }
+    else if (opCode == 0xFB) { *mnemonic = "EI"; return 1; }
+    else if (opCode == 0xFC) { *mnemonic = "CM"; return 3; }
+    else if (opCode == 0xFE) { *mnemonic = "CPI"; return 2; }
+    *mnemonic = NULL;
+    return 1;
+}
+
+static int tableDecode(int opCode, const char **mnemonic) {
+    const OpcodeInfo *info = &opcodeTable[opCode];
+    *mnemonic = info->mnemonic;
+    return info->length;
+}
+
+// Linear sweeps over the image, return a checksum so the decoding can't be optimized away
+static size_t sweepChain(const uint8_t *image, size_t size) {
+    size_t checksum = 0;
+    for (size_t pc = 0; pc < size;) {
+        const char *mnemonic;
+        pc += legacyDecode(image[pc], &mnemonic);
+        checksum += (size_t) mnemonic;
+    }
+    return checksum;
+}
+
+static size_t sweepTable(const uint8_t *image, size_t size) {
+    size_t checksum = 0;
+    for (size_t pc = 0; pc < size;) {
+        const char *mnemonic;
+        pc += tableDecode(image[pc], &mnemonic);
+        checksum += (size_t) mnemonic;
+    }
+    return checksum;
+}
+
+static double measure(const char *name, const uint8_t *image, size_t size, size_t (*sweep)(const uint8_t *, size_t)) {
+    size_t instructions = 0;
+    for (size_t pc = 0; pc < size; instructions++) {
+        pc += opcodeTable[image[pc]].length;
+    }
+
+    volatile size_t checksum = 0;
+    double start = clockNow();
+    for (int i = 0; i < ITERATIONS; i++) {
+        checksum += sweep(image, size);
+    }
+    double elapsed = clockNow() - start;
+
+    double nanoseconds = elapsed * 1e9 / ((double) instructions * ITERATIONS);
+    printf("%-8s %8.3f ns/instruction %10.1f M instructions/s\n", name, nanoseconds, 1e3 / nanoseconds);
+    benchRecord("decode", name, 1e3 / nanoseconds, "M instructions/s", 1);
+    return elapsed;
+}
+
+int main(int argc, char **argv) {
+    if (argc < 2) {
+        fprintf(stderr, "USAGE: decode_bench FILE...\n");
+        return 1;
+    }
+
+    static uint8_t image[0x10000];
+    long size = benchLoadFiles(argc - 1, argv + 1, image, sizeof(image));
+    if (size <= 0) {
+        return 1;
+    }
+
+    // The table only differs in decoding SPHL, which the chain missed
+    for (int opCode = 0; opCode < 256; opCode++) {
+        if (opCode == 0xF9) {
+            continue;
+        }
+        const char *legacyMnemonic, *tableMnemonic;
+        int legacyLength = legacyDecode(opCode, &legacyMnemonic);
+        int tableLength = tableDecode(opCode, &tableMnemonic);
+        if (legacyLength != tableLength || (legacyMnemonic == NULL) != (tableMnemonic == NULL)) {
+            fprintf(stderr, "Decoders disagree on opcode %02X\n", opCode);
+            return 1;
+        }
+    }
+
+    double chain = measure("chain", image, (size_t) size, sweepChain);
+    double table = measure("table", image, (size_t) size, sweepTable);
+    printf("speedup  %8.2fx\n", chain / table);
+
+    return 0;
+}
+
+#pragma clang diagnostic pop
@@ -0,0 +1,91 @@
+// Measures how many bytes of code per second the sequential and the parallel disassembler turn into a listing
+// written to /dev/null. The parallel_listing test checks that both write the same listing.
+// USAGE: disassembly_bench MANIFEST [ITERATIONS] (e.g. rom/spaceinvaders/manifest)
+
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+#include "bench.h"
+#include "../src/format.h"
+#include "../src/parallel.h"
+#include "../src/rom.h"
+#include "../src/threadpool.h"
+
+// The linear sweep of the disassembler, without its messages about invalid opcodes
+static int listSweep(const uint8_t *code, size_t size, OutputBuffer *output) {
+    Instruction instruction;
+    int length;
+    for (size_t pc = 0; pc < size; pc += length) {
+        length = decodeInstruction(code, size, pc, &instruction);
+        if (length == 0) {
+            break;
+        }
+        if (formatInstruction(output, pc, &instruction) != 0) {
+            return -1;
+        }
+    }
+    return 0;
+}
+
+static int disassembleSequential(const uint8_t *code, size_t size, int fd) {
+    OutputBuffer output;
+    if (initOutputBuffer(&output, fd) != 0) {
+        return -1;
+    }
+    int status = listSweep(code, size, &output) != 0 || flushOutput(&output) != 0 ? -1 : 0;
+    freeOutputBuffer(&output);
+    return status;
+}
+
+static double measure(const char *name, const uint8_t *code, size_t size, int threadCount, int iterations, int fd) {
+    double start = clockNow();
+    for (int i = 0; i < iterations; i++) {
+        if (threadCount > 0) {
+            disassembleParallel(code, size, threadCount, fd);
+        } else {
+            disassembleSequential(code, size, fd);
+        }
+    }
+    double elapsed = clockNow() - start;
+
+    double bytesPerSecond = (double) size * iterations / elapsed;
+    printf("%-10s %8.1f MB/s %8.2f us/listing\n", name, bytesPerSecond / 1e6, elapsed * 1e6 / iterations);
+    benchRecord("disassembly", name, bytesPerSecond / 1e6, "MB/s", 1);
+    return elapsed;
+}
+
+int main(int argc, char **argv) {
+    if (argc < 2) {
+        fprintf(stderr, "USAGE: disassembly_bench MANIFEST [ITERATIONS]\n");
+        return 1;
+    }
+    int iterations = argc > 2 ? atoi(argv[2]) : 2000;
+
+    static uint8_t memory[MEMORY_SIZE];
+    long end = loadRomSet(argv[1], memory);
+    if (end <= 0) {
+        return 1;
+    }
+    size_t size = (size_t) end;
+    int threadCount = threadPoolDefaultSize();
+
+    // Both disassemblers report invalid opcodes on stderr, once per listing
+    int savedStderr = dup(STDERR_FILENO);
+    int devNull = open("/dev/null", O_WRONLY);
+    if (savedStderr < 0 || devNull < 0) {
+        perror("/dev/null");
+        return 1;
+    }
+    dup2(devNull, STDERR_FILENO);
+
+    double sequentialElapsed = measure("sequential", memory, size, 0, iterations, devNull);
+    double parallelElapsed = measure("parallel", memory, size, threadCount, iterations, devNull);
+    dup2(savedStderr, STDERR_FILENO);
+    close(savedStderr);
+    close(devNull);
+
+    printf("speedup    %8.2fx on %d threads\n", sequentialElapsed / parallelElapsed, threadCount);
+    return 0;
+}
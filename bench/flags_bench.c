@@ -0,0 +1,61 @@
+#pragma clang diagnostic push
+#pragma ide diagnostic ignored "hicpp-signed-bitwise"
+
+// Compares the speed of the table driven flags of lazyFlags(), which the CPU computes at once or, with
+// CPU_LAZY_FLAGS, when they are read, with the bitwise reference flags_check tests them against.
+// USAGE: flags_bench
+
+#include <stdio.h>
+
+#include "bench.h"
+#include "../src/flags.h"
+#include "../test/flags_reference.h"
+
+#define ITERATIONS 200
+
+// Flags as the CPU sets them, S, Z, AC and P from the tables and CY from the sum computed wider
+static unsigned int sweepTables(void) {
+    unsigned int checksum = 0;
+    for (int operand = 0; operand < 256; operand++) {
+        for (int value = 0; value < 256; value++) {
+            unsigned int sum = (unsigned int) (operand + value);
+            checksum += lazyFlags(LAZY_ADD, (uint8_t) operand, (uint8_t) value, (uint8_t) sum) | ((sum >> 8) & FLAG_CY);
+            unsigned int difference = (unsigned int) (operand - value);
+            checksum += lazyFlags(LAZY_SUBTRACT, (uint8_t) operand, (uint8_t) value, (uint8_t) difference) |
+                        ((difference >> 8) & FLAG_CY);
+        }
+    }
+    return checksum;
+}
+
+static unsigned int sweepReference(void) {
+    unsigned int checksum = 0;
+    for (int operand = 0; operand < 256; operand++) {
+        for (int value = 0; value < 256; value++) {
+            checksum += referenceAdditionFlags((uint8_t) operand, (uint8_t) value, 0);
+            checksum += referenceSubtractionFlags((uint8_t) operand, (uint8_t) value, 0);
+        }
+    }
+    return checksum;
+}
+
+static double measure(const char *name, unsigned int (*sweep)(void)) {
+    volatile unsigned int checksum = 0;
+    double start = clockNow();
+    for (int i = 0; i < ITERATIONS; i++) {
+        checksum += sweep();
+    }
+    double elapsed = clockNow() - start;
+    printf("%-10s %8.3f ns/operation\n", name, elapsed * 1e9 / (2.0 * 256 * 256 * ITERATIONS));
+    benchRecord("flags", name, elapsed * 1e9 / (2.0 * 256 * 256 * ITERATIONS), "ns/operation", 0);
+    return elapsed;
+}
+
+int main(void) {
+    double reference = measure("bitwise", sweepReference);
+    double tables = measure("tables", sweepTables);
+    printf("speedup    %8.2fx\n", reference / tables);
+    return 0;
+}
+
+#pragma clang diagnostic pop
@@ -0,0 +1,70 @@
+// Runs Space Invaders headless on the interpreter and on the JIT, checks both end in the same state and compares
+// their speed. jit_check tests the JIT against the interpreter in lockstep.
+// USAGE: jit_bench MANIFEST [SECONDS] (e.g. rom/spaceinvaders/manifest)
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "bench.h"
+#include "../src/jit.h"
+
+static uint64_t runJit(void *context, uint64_t cycles) {
+    return jitRun(context, cycles);
+}
+
+static double run(const char *name, SpaceInvaders *invaders, int seconds) {
+    double elapsed = benchRunInvaders(invaders, seconds);
+
+    const Cpu *cpu = &invaders->machine.cpu;
+    printf("%-12s %8.1f MIPS %8.1f MHz\n", name, (double) cpu->instructions / elapsed / 1e6,
+           (double) cpu->cycles / elapsed / 1e6);
+    benchRecord("jit", name, (double) cpu->instructions / elapsed / 1e6, "MIPS", 1);
+    return elapsed;
+}
+
+int main(int argc, char **argv) {
+    if (argc < 2) {
+        fprintf(stderr, "USAGE: jit_bench MANIFEST [SECONDS]\n");
+        return 1;
+    }
+    int seconds = argc > 2 ? atoi(argv[2]) : 60;
+
+    if (!JIT_NATIVE) {
+        printf("No native code generation on this platform, the JIT only interprets\n");
+    }
+
+    static SpaceInvaders interpreterBoard;
+    if (benchLoadInvaders(&interpreterBoard, argv[1]) != 0) {
+        return 1;
+    }
+    double interpreterElapsed = run("interpreter", &interpreterBoard, seconds);
+
+    static SpaceInvaders jitBoard;
+    Jit jit;
+    if (benchLoadInvaders(&jitBoard, argv[1]) != 0) {
+        return 1;
+    }
+    if (jitInit(&jit, &jitBoard.machine.cpu) < 0) {
+        fprintf(stderr, "Failed to allocate the JIT\n");
+        return 1;
+    }
+    machineSetRunner(&jitBoard.machine, runJit, &jit);
+    double jitElapsed = run("jit", &jitBoard, seconds);
+    printf("speedup      %8.2fx\n", interpreterElapsed / jitElapsed);
+    printf("blocks       %llu translated, %llu native runs, %llu invalidations, %llu flushes\n",
+           (unsigned long long) jit.translations, (unsigned long long) jit.nativeRuns,
+           (unsigned long long) jit.invalidations, (unsigned long long) jit.flushes);
+    machineSetRunner(&jitBoard.machine, NULL, NULL);
+    jitFree(&jit);
+
+    const Cpu *interpreterCpu = &interpreterBoard.machine.cpu;
+    const Cpu *jitCpu = &jitBoard.machine.cpu;
+    if (jitCpu->cycles != interpreterCpu->cycles || jitCpu->instructions != interpreterCpu->instructions ||
+        jitCpu->pc != interpreterCpu->pc || memcmp(jitCpu->registers, interpreterCpu->registers, 8) != 0 ||
+        jitCpu->flags != interpreterCpu->flags || memcmp(jitCpu->memory, interpreterCpu->memory, MEMORY_SIZE) != 0) {
+        fprintf(stderr, "The interpreter and the JIT ended in different states\n");
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,57 @@
+# Runs the benchmarks with BENCH_JSON pointing at a scratch file, then writes their results as one JSON array to
+# OUTPUT and compares them with BASELINE if one is given. The CP/M diagnostics in CPU_TEST_DIR run as well if it is
+# set.
+# USAGE: cmake -DBENCH_DIR=DIR -DROM_DIR=DIR -DOUTPUT=FILE [-DBASELINE=FILE] [-DTHRESHOLD=PERCENT]
+#              [-DCPU_TEST_DIR=DIR] -P run_benchmarks.cmake
+
+set(INVADERS ${ROM_DIR}/spaceinvaders)
+set(RESULTS ${OUTPUT}.lines)
+file(REMOVE ${RESULTS})
+
+function(run_benchmark name)
+    list(JOIN ARGN " " arguments)
+    message(STATUS "${name} ${arguments}")
+    execute_process(
+            COMMAND ${CMAKE_COMMAND} -E env BENCH_JSON=${RESULTS} ${BENCH_DIR}/${name} ${ARGN}
+            RESULT_VARIABLE status)
+    if(NOT status EQUAL 0)
+        message(FATAL_ERROR "${name} failed")
+    endif()
+endfunction()
+
+run_benchmark(decode_bench ${INVADERS}/invaders.h ${INVADERS}/invaders.g ${INVADERS}/invaders.f ${INVADERS}/invaders.e)
+run_benchmark(disassembly_bench ${INVADERS}/manifest)
+run_benchmark(flags_bench)
+run_benchmark(cpu_bench ${INVADERS}/manifest 60)
+run_benchmark(blockcache_bench ${INVADERS}/manifest 60)
+run_benchmark(jit_bench ${INVADERS}/manifest 60)
+run_benchmark(trace_bench ${INVADERS}/manifest ${OUTPUT}.trace 10)
+run_benchmark(snapshot_bench ${INVADERS}/manifest ${OUTPUT}.snapshot)
+run_benchmark(video_bench ${INVADERS}/manifest 30)
+file(REMOVE ${OUTPUT}.trace ${OUTPUT}.snapshot ${OUTPUT}.snapshot.delta)
+
+if(CPU_TEST_DIR)
+    file(GLOB programs ${CPU_TEST_DIR}/*.COM ${CPU_TEST_DIR}/*.com)
+    if(NOT programs)
+        message(FATAL_ERROR "No .COM programs in ${CPU_TEST_DIR}")
+    endif()
+    run_benchmark(conformance_bench ${programs})
+endif()
+
+file(STRINGS ${RESULTS} lines)
+list(JOIN lines ",\n  " results)
+file(WRITE ${OUTPUT} "[\n  ${results}\n]\n")
+file(REMOVE ${RESULTS})
+message(STATUS "Results written to ${OUTPUT}")
+
+if(BASELINE)
+    if(NOT THRESHOLD)
+        set(THRESHOLD 10)
+    endif()
+    execute_process(
+            COMMAND ${BENCH_DIR}/bench_compare -t ${THRESHOLD} ${BASELINE} ${OUTPUT}
+            RESULT_VARIABLE status)
+    if(NOT status EQUAL 0)
+        message(FATAL_ERROR "Benchmarks regressed against ${BASELINE}")
+    endif()
+endif()
@@ -0,0 +1,96 @@
+// Boots Space Invaders to its attract mode, snapshots it and forks many one-frame branches from that snapshot, then
+// compares delta restores and takes with full 64 KiB copies and the size of a full and a delta snapshot file.
+// snapshot_check tests that the branches end in the same state as a board which ran on without snapshots.
+// USAGE: snapshot_bench MANIFEST SNAPSHOT_FILE [BRANCHES] (e.g. rom/spaceinvaders/manifest /tmp/invaders.snapshot)
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+
+#include "bench.h"
+#include "../src/snapshot.h"
+
+#define BOOT_SECONDS 10
+
+static long fileSize(const char *fileName) {
+    struct stat status;
+    return stat(fileName, &status) == 0 ? (long) status.st_size : -1;
+}
+
+int main(int argc, char **argv) {
+    if (argc < 3) {
+        fprintf(stderr, "USAGE: snapshot_bench MANIFEST SNAPSHOT_FILE [BRANCHES]\n");
+        return 1;
+    }
+    int branches = argc > 3 ? atoi(argv[3]) : 10000;
+
+    static SpaceInvaders invaders;
+    SnapshotTracker tracker;
+    if (benchLoadInvaders(&invaders, argv[1]) != 0 || snapshotTrackerInit(&tracker, &invaders.machine.cpu) != 0) {
+        return 1;
+    }
+    Machine *machine = &invaders.machine;
+    machineRunFrames(machine, BOOT_SECONDS * INVADERS_FRAME_RATE);
+    Snapshot *fork = snapshotTake(&tracker);
+    if (fork == NULL) {
+        return 1;
+    }
+
+    // The snapshot holds the CPU and its memory, the frame timeline of the machine goes back to the fork by hand so
+    // that every branch runs the same frame
+    static uint8_t forkMemory[MEMORY_SIZE];
+    memcpy(forkMemory, machine->memory, MEMORY_SIZE);
+    Cpu forkCpu = machine->cpu;
+    uint64_t forkFrameStart = machine->frameStart;
+
+    double restoreTime = 0;
+    double takeTime = 0;
+    Snapshot *branch = NULL;
+    for (int i = 0; i < branches; i++) {
+        double start = clockNow();
+        snapshotRestore(&tracker, fork);
+        restoreTime += clockNow() - start;
+        machine->frameStart = forkFrameStart;
+        machineRunFrame(machine);
+
+        snapshotRelease(branch);
+        start = clockNow();
+        branch = snapshotTake(&tracker);
+        takeTime += clockNow() - start;
+        if (branch == NULL) {
+            return 1;
+        }
+    }
+
+    double copyTime = 0;
+    for (int i = 0; i < branches; i++) {
+        double start = clockNow();
+        memcpy(machine->memory, forkMemory, MEMORY_SIZE);
+        machine->cpu = forkCpu;
+        copyTime += clockNow() - start;
+        machine->frameStart = forkFrameStart;
+        machineRunFrame(machine);
+    }
+    printf("%d branches of one frame\n", branches);
+    printf("snapshot restore %8.3f us\n", restoreTime * 1e6 / branches);
+    printf("snapshot take    %8.3f us\n", takeTime * 1e6 / branches);
+    printf("full copy        %8.3f us\n", copyTime * 1e6 / branches);
+    printf("take speedup     %8.2fx over a full copy\n", copyTime / takeTime);
+    benchRecord("snapshot", "restore", restoreTime * 1e6 / branches, "us", 0);
+    benchRecord("snapshot", "take", takeTime * 1e6 / branches, "us", 0);
+    benchRecord("snapshot", "full copy", copyTime * 1e6 / branches, "us", 0);
+
+    // A branch saved as a delta against the fork point only holds the pages the frame wrote to
+    char deltaName[4096];
+    snprintf(deltaName, sizeof(deltaName), "%s.delta", argv[2]);
+    if (snapshotSave(fork, NULL, argv[2]) != 0 || snapshotSave(branch, fork, deltaName) != 0) {
+        return 1;
+    }
+    printf("full file %6ld bytes, delta file %6ld bytes\n", fileSize(argv[2]), fileSize(deltaName));
+
+    snapshotRelease(fork);
+    snapshotRelease(branch);
+    snapshotTrackerFree(&tracker);
+    return 0;
+}
@@ -0,0 +1,66 @@
+// Runs Space Invaders headless without and with a binary trace of every instruction, checks the trace holds one
+// record per instruction and reports what recording costs per instruction.
+// USAGE: trace_bench MANIFEST TRACE_FILE [SECONDS] (e.g. rom/spaceinvaders/manifest /tmp/invaders.trace)
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+
+#include "bench.h"
+#include "../src/trace.h"
+
+static double run(const char *name, SpaceInvaders *invaders, int seconds) {
+    double elapsed = benchRunInvaders(invaders, seconds);
+
+    const Cpu *cpu = &invaders->machine.cpu;
+    printf("%-8s %8.1f MIPS %8.2f ns/instruction\n", name, (double) cpu->instructions / elapsed / 1e6,
+           elapsed * 1e9 / (double) cpu->instructions);
+    benchRecord("trace", name, (double) cpu->instructions / elapsed / 1e6, "MIPS", 1);
+    return elapsed;
+}
+
+int main(int argc, char **argv) {
+    if (argc < 3) {
+        fprintf(stderr, "USAGE: trace_bench MANIFEST TRACE_FILE [SECONDS]\n");
+        return 1;
+    }
+    int seconds = argc > 3 ? atoi(argv[3]) : 10;
+
+    static SpaceInvaders plainBoard;
+    if (benchLoadInvaders(&plainBoard, argv[1]) != 0) {
+        return 1;
+    }
+    double plainElapsed = run("plain", &plainBoard, seconds);
+
+    static SpaceInvaders tracedBoard;
+    Tracer tracer;
+    if (benchLoadInvaders(&tracedBoard, argv[1]) != 0 || traceOpen(&tracer, argv[2], 0) != 0) {
+        return 1;
+    }
+    Cpu *tracedCpu = &tracedBoard.machine.cpu;
+    tracedCpu->trace = traceInstruction;
+    tracedCpu->traceContext = &tracer;
+    double tracedElapsed = run("traced", &tracedBoard, seconds);
+    if (traceClose(&tracer) != 0) {
+        fprintf(stderr, "Writing the trace failed\n");
+        return 1;
+    }
+    printf("overhead %8.2f ns/instruction, %llu stalls on a full ring\n",
+           (tracedElapsed - plainElapsed) * 1e9 / (double) tracedCpu->instructions,
+           (unsigned long long) tracer.stalls);
+
+    struct stat status;
+    if (stat(argv[2], &status) != 0 ||
+        (uint64_t) status.st_size != sizeof(TraceHeader) + tracedCpu->instructions * sizeof(TraceRecord)) {
+        fprintf(stderr, "The trace doesn't hold one record per instruction\n");
+        return 1;
+    }
+    const Cpu *plainCpu = &plainBoard.machine.cpu;
+    if (tracedCpu->cycles != plainCpu->cycles || tracedCpu->pc != plainCpu->pc ||
+        memcmp(tracedCpu->memory, plainCpu->memory, MEMORY_SIZE) != 0) {
+        fprintf(stderr, "Tracing changed the emulation\n");
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,77 @@
+// Plays the first seconds of a Space Invaders game and converts the video RAM after every frame with each kernel,
+// once incrementally from the dirty lines and once in full, and compares the time the conversions take. video_check
+// tests every picture against a full scalar conversion.
+// USAGE: video_bench MANIFEST [SECONDS] (e.g. rom/spaceinvaders/manifest)
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "bench.h"
+#include "../src/invaders.h"
+#include "../src/video.h"
+
+#define KERNEL_COUNT 3
+
+int main(int argc, char **argv) {
+    if (argc < 2) {
+        fprintf(stderr, "USAGE: video_bench MANIFEST [SECONDS]\n");
+        return 1;
+    }
+    int seconds = argc > 2 ? atoi(argv[2]) : 30;
+
+    static SpaceInvaders invaders;
+    invadersInit(&invaders);
+    Machine *machine = &invaders.machine;
+    if (loadRomSet(argv[1], machine->memory) < 0) {
+        return 1;
+    }
+
+    VideoKernel best = videoBestKernel();
+    Video incremental[KERNEL_COUNT];
+    Video full[KERNEL_COUNT];
+    int kernelCount = (int) best + 1;
+    for (int kernel = 0; kernel < kernelCount; kernel++) {
+        if (videoInit(&incremental[kernel], &machine->cpu, (VideoKernel) kernel) != 0 ||
+            videoInit(&full[kernel], &machine->cpu, (VideoKernel) kernel) != 0) {
+            return 1;
+        }
+    }
+
+    double incrementalTime[KERNEL_COUNT] = {0};
+    double fullTime[KERNEL_COUNT] = {0};
+    int frames = seconds * INVADERS_FRAME_RATE;
+    for (int frame = 0; frame < frames; frame++) {
+        invaders.inputs[0] = invadersScriptedInputs((uint64_t) frame, 0);
+        machineRunFrame(machine);
+
+        for (int kernel = 0; kernel < kernelCount; kernel++) {
+            double start = clockNow();
+            videoUpdate(&incremental[kernel]);
+            incrementalTime[kernel] += clockNow() - start;
+
+            start = clockNow();
+            videoInvalidate(&full[kernel]);
+            videoUpdate(&full[kernel]);
+            fullTime[kernel] += clockNow() - start;
+        }
+    }
+
+    printf("%d frames\n", frames);
+    for (int kernel = 0; kernel < kernelCount; kernel++) {
+        printf("%-6s full %8.2f us/frame, incremental %8.2f us/frame (%5.1f lines)\n",
+               videoKernelName((VideoKernel) kernel), fullTime[kernel] * 1e6 / frames,
+               incrementalTime[kernel] * 1e6 / frames,
+               (double) incremental[kernel].convertedLines / (double) frames);
+        char metric[32];
+        snprintf(metric, sizeof(metric), "%s full", videoKernelName((VideoKernel) kernel));
+        benchRecord("video", metric, fullTime[kernel] * 1e6 / frames, "us/frame", 0);
+        snprintf(metric, sizeof(metric), "%s incremental", videoKernelName((VideoKernel) kernel));
+        benchRecord("video", metric, incrementalTime[kernel] * 1e6 / frames, "us/frame", 0);
+    }
+
+    for (int kernel = 0; kernel < kernelCount; kernel++) {
+        videoFree(&incremental[kernel]);
+        videoFree(&full[kernel]);
+    }
+    return 0;
+}
@@ -0,0 +1,141 @@
+#pragma clang diagnostic push
+#pragma ide diagnostic ignored "hicpp-signed-bitwise"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "analysis.h"
+#include "opcodes.h"
+
+#define MARK(bitmap, address) ((bitmap)[(address) >> 3] |= 1 << ((address) & 0x7))
+
+typedef struct {
+    size_t *addresses;
+    size_t count;
+    size_t capacity;
+} Worklist;
+
+static int push(Worklist *worklist, size_t address) {
+    if (worklist->count == worklist->capacity) {
+        size_t capacity = worklist->capacity ? worklist->capacity * 2 : 256;
+        size_t *addresses = realloc(worklist->addresses, capacity * sizeof(size_t));
+        if (addresses == NULL) {
+            return -1;
+        }
+        worklist->addresses = addresses;
+        worklist->capacity = capacity;
+    }
+    worklist->addresses[worklist->count++] = address;
+    return 0;
+}
+
+static int addCall(Analysis *analysis, size_t site, size_t target) {
+    if (analysis->callCount == analysis->callCapacity) {
+        size_t capacity = analysis->callCapacity ? analysis->callCapacity * 2 : 64;
+        CallEdge *calls = realloc(analysis->calls, capacity * sizeof(CallEdge));
+        if (calls == NULL) {
+            return -1;
+        }
+        analysis->calls = calls;
+        analysis->callCapacity = capacity;
+    }
+    analysis->calls[analysis->callCount].site = site;
+    analysis->calls[analysis->callCount].target = target;
+    analysis->callCount++;
+    return 0;
+}
+
+// Decodes the path starting at pc until it ends or joins code already visited. Branch targets are queued.
+static int followPath(Analysis *analysis, Worklist *worklist, size_t pc) {
+    Instruction instruction;
+    while (pc < analysis->size && !IS_MARKED(analysis->instructions, pc)) {
+        int length = decodeInstruction(analysis->code, analysis->size, pc, &instruction);
+        if (length == 0 || instruction.info->operandKind == OPERAND_INVALID) {
+            return 0;
+        }
+        MARK(analysis->instructions, pc);
+        for (int i = 0; i < length; i++) {
+            MARK(analysis->codeBytes, pc + i);
+        }
+
+        size_t target = instruction.operand;
+        switch (instruction.info->flow) {
+            case FLOW_JUMP:
+                return push(worklist, target);
+            case FLOW_CONDITIONAL_JUMP:
+                if (push(worklist, target) != 0) {
+                    return -1;
+                }
+                break;
+            case FLOW_RESTART:
+                target = (size_t) instruction.info->dst * 8;
+                // fall through
+            case FLOW_CALL:
+            case FLOW_CONDITIONAL_CALL:
+                if (push(worklist, target) != 0 || addCall(analysis, pc, target) != 0) {
+                    return -1;
+                }
+                break;
+            case FLOW_RETURN:
+            case FLOW_INDIRECT_JUMP:
+                return 0;
+            default:
+                break;
+        }
+        pc += length;
+    }
+    return 0;
+}
+
+int analyzeCode(Analysis *analysis, const uint8_t *code, size_t size, const size_t *entries, size_t entryCount) {
+    memset(analysis, 0, sizeof(*analysis));
+    analysis->code = code;
+    analysis->size = size;
+    analysis->instructions = calloc(size / 8 + 1, 1);
+    analysis->codeBytes = calloc(size / 8 + 1, 1);
+    Worklist worklist = {NULL, 0, 0};
+    int status = analysis->instructions != NULL && analysis->codeBytes != NULL ? 0 : -1;
+    for (size_t i = 0; i < entryCount && status == 0; i++) {
+        status = push(&worklist, entries[i]);
+    }
+
+    // Entry points are followed in the order given
+    for (size_t i = 0; i < worklist.count / 2; i++) {
+        size_t address = worklist.addresses[i];
+        worklist.addresses[i] = worklist.addresses[worklist.count - 1 - i];
+        worklist.addresses[worklist.count - 1 - i] = address;
+    }
+    while (worklist.count > 0 && status == 0) {
+        status = followPath(analysis, &worklist, worklist.addresses[--worklist.count]);
+    }
+    free(worklist.addresses);
+
+    if (status != 0) {
+        fprintf(stderr, "Cannot allocate the code analysis of %zu bytes\n", size);
+        freeAnalysis(analysis);
+    }
+    return status;
+}
+
+void freeAnalysis(Analysis *analysis) {
+    free(analysis->instructions);
+    free(analysis->codeBytes);
+    free(analysis->calls);
+    memset(analysis, 0, sizeof(*analysis));
+}
+
+static int compareCalls(const void *a, const void *b) {
+    const CallEdge *first = a;
+    const CallEdge *second = b;
+    if (first->target != second->target) {
+        return first->target < second->target ? -1 : 1;
+    }
+    return first->site < second->site ? -1 : first->site > second->site;
+}
+
+void sortCalls(Analysis *analysis) {
+    qsort(analysis->calls, analysis->callCount, sizeof(CallEdge), compareCalls);
+}
+
+#pragma clang diagnostic pop
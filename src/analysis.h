@@ -0,0 +1,38 @@
+#ifndef ANALYSIS_H
+#define ANALYSIS_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+// A CALL, conditional call or RST at site transferring control to target
+typedef struct {
+    size_t site;
+    size_t target;
+} CallEdge;
+
+typedef struct {
+    const uint8_t *code;
+    size_t size;
+    // One bit per address: the address starts an instruction reached from an entry point
+    uint8_t *instructions;
+    // One bit per address: the byte belongs to such an instruction
+    uint8_t *codeBytes;
+    CallEdge *calls;
+    size_t callCount;
+    size_t callCapacity;
+} Analysis;
+
+#define IS_MARKED(bitmap, address) (((bitmap)[(address) >> 3] >> ((address) & 0x7)) & 1)
+
+// Follows every path of control flow from the entry points: jumps, calls (assumed to return), conditional
+// forms, RST and fall through. Ends a path at RET, an unconditional JMP, PCHL or an undocumented opcode, targets of
+// PCHL have to be given as entry points. Every address is decoded at most once.
+// Returns 0 on success, -1 on failure.
+int analyzeCode(Analysis *analysis, const uint8_t *code, size_t size, const size_t *entries, size_t entryCount);
+
+void freeAnalysis(Analysis *analysis);
+
+// Sorts the call graph by target, then by call site
+void sortCalls(Analysis *analysis);
+
+#endif
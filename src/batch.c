@@ -0,0 +1,123 @@
+// Runs many independent Space Invaders machines headless on a pool of worker threads and reports the aggregate
+// emulation speed. Every instance owns its memory and CPU, instances only share the read-only ROM image.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "clock.h"
+#include "invaders.h"
+#include "threadpool.h"
+
+typedef struct {
+    const uint8_t *rom;
+    int seconds;
+    Cpu cpu;
+    // CRC-32 of the memory when the instance stopped
+    uint32_t checksum;
+    int failed;
+} Instance;
+
+static void runInstance(void *argument) {
+    Instance *instance = argument;
+    SpaceInvaders *invaders = malloc(sizeof(SpaceInvaders));
+    if (invaders == NULL) {
+        instance->failed = 1;
+        return;
+    }
+    invadersInit(invaders);
+    memcpy(invaders->machine.memory, instance->rom, MEMORY_SIZE);
+    machineRunFrames(&invaders->machine, (uint64_t) instance->seconds * INVADERS_FRAME_RATE);
+
+    instance->cpu = invaders->machine.cpu;
+    instance->cpu.memory = NULL;
+    instance->checksum = crc32(invaders->machine.memory, MEMORY_SIZE);
+    free(invaders);
+}
+
+int main(int argc, char **argv) {
+    int threadCount = threadPoolDefaultSize();
+    int instanceCount = 0;
+    int seconds = 10;
+    int verbose = 0;
+    int option;
+    while ((option = getopt(argc, argv, "j:n:s:v")) != -1) {
+        switch (option) {
+            case 'j':
+                threadCount = atoi(optarg);
+                break;
+            case 'n':
+                instanceCount = atoi(optarg);
+                break;
+            case 's':
+                seconds = atoi(optarg);
+                break;
+            case 'v':
+                verbose = 1;
+                break;
+            default:
+                fprintf(stderr, "USAGE: batch [-j THREADS] [-n INSTANCES] [-s SECONDS] [-v] MANIFEST\n");
+                return 1;
+        }
+    }
+    if (optind != argc - 1 || threadCount < 1 || instanceCount < 0 || seconds < 0) {
+        fprintf(stderr, "USAGE: batch [-j THREADS] [-n INSTANCES] [-s SECONDS] [-v] MANIFEST\n");
+        return 1;
+    }
+    if (instanceCount == 0) {
+        instanceCount = threadCount;
+    }
+
+    static uint8_t rom[MEMORY_SIZE];
+    if (loadRomSet(argv[optind], rom) < 0) {
+        return 1;
+    }
+
+    Instance *instances = calloc((size_t) instanceCount, sizeof(Instance));
+    if (instances == NULL) {
+        fprintf(stderr, "Cannot allocate %d instances\n", instanceCount);
+        return 1;
+    }
+    ThreadPool pool;
+    if (threadPoolInit(&pool, threadCount) != 0) {
+        free(instances);
+        return 1;
+    }
+
+    double start = clockNow();
+    int status = 0;
+    for (int i = 0; i < instanceCount; i++) {
+        instances[i].rom = rom;
+        instances[i].seconds = seconds;
+        if (threadPoolSubmit(&pool, runInstance, &instances[i]) != 0) {
+            instances[i].failed = 1;
+        }
+    }
+    threadPoolWait(&pool);
+    double elapsed = clockNow() - start;
+    threadPoolFree(&pool);
+
+    uint64_t instructions = 0;
+    uint64_t cycles = 0;
+    for (int i = 0; i < instanceCount; i++) {
+        if (instances[i].failed) {
+            fprintf(stderr, "Instance %d failed\n", i);
+            status = 1;
+            continue;
+        }
+        instructions += instances[i].cpu.instructions;
+        cycles += instances[i].cpu.cycles;
+        if (verbose) {
+            printf("%6d pc=%04X cycles=%llu instructions=%llu memory=%08X\n", i, instances[i].cpu.pc,
+                   (unsigned long long) instances[i].cpu.cycles,
+                   (unsigned long long) instances[i].cpu.instructions, instances[i].checksum);
+        }
+    }
+    printf("%d instances on %d threads in %.3f s\n", instanceCount, threadCount, elapsed);
+    printf("%.1f MIPS %.1f MHz %.0fx real time\n", (double) instructions / elapsed / 1e6,
+           (double) cycles / elapsed / 1e6, (double) cycles / INVADERS_CLOCK_RATE / elapsed);
+
+    free(instances);
+    return status;
+}
@@ -0,0 +1,174 @@
+#pragma clang diagnostic push
+#pragma ide diagnostic ignored "hicpp-signed-bitwise"
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "blockcache.h"
+#include "opcodes.h"
+#include "rom.h"
+
+// Longest distance from the start of a block to its last byte
+#define BLOCK_MAX_SPAN (BLOCK_MAX_INSTRUCTIONS * 3)
+
+static void freeRetiredBlocks(BlockCache *cache) {
+    while (cache->retired != NULL) {
+        Block *block = cache->retired;
+        cache->retired = block->nextRetired;
+        free(block);
+    }
+}
+
+static void markCode(BlockCache *cache, const Block *block) {
+    int end = block->start + (uint16_t) (block->end - block->start);
+    for (int address = block->start; address < end; address++) {
+        cache->codeMap[address >> 3] |= 1 << (address & 0x7);
+        cache->cpu->watchedPages[address >> CPU_PAGE_SHIFT] |= cache->watcherBit;
+    }
+}
+
+// Unmarks the addresses from up to end which no block covers any longer, and stops watching pages left without code
+static void unmarkCode(BlockCache *cache, int from, int end) {
+    for (int address = from; address < end; address++) {
+        cache->codeMap[address >> 3] &= ~(1 << (address & 0x7));
+    }
+    for (int start = from > BLOCK_MAX_SPAN ? from - BLOCK_MAX_SPAN : 0; start < end; start++) {
+        if (cache->blocks[start] != NULL) {
+            markCode(cache, cache->blocks[start]);
+        }
+    }
+
+    const int bytesPerPage = (1 << CPU_PAGE_SHIFT) >> 3;
+    for (int page = from >> CPU_PAGE_SHIFT; page <= (end - 1) >> CPU_PAGE_SHIFT; page++) {
+        const uint8_t *map = cache->codeMap + page * bytesPerPage;
+        int code = 0;
+        for (int i = 0; i < bytesPerPage; i++) {
+            code |= map[i];
+        }
+        if (!code) {
+            cache->cpu->watchedPages[page] &= ~cache->watcherBit;
+        }
+    }
+}
+
+// Retires every block which covers the written address
+static void invalidateBlocks(void *context, uint16_t address) {
+    BlockCache *cache = context;
+    if (!(cache->codeMap[address >> 3] & (1 << (address & 0x7)))) {
+        return;
+    }
+
+    int from = address + 1;
+    int end = address;
+    for (int offset = 0; offset < BLOCK_MAX_SPAN && offset <= address; offset++) {
+        Block *block = cache->blocks[address - offset];
+        int blockEnd = block != NULL ? block->start + (uint16_t) (block->end - block->start) : 0;
+        if (address < blockEnd) {
+            cache->blocks[block->start] = NULL;
+            block->nextRetired = cache->retired;
+            cache->retired = block;
+            cache->invalidations++;
+            cache->stop = 1;
+            from = block->start < from ? block->start : from;
+            end = blockEnd > end ? blockEnd : end;
+        }
+    }
+    if (from < end) {
+        unmarkCode(cache, from, end);
+    }
+}
+
+static Block *translateBlock(BlockCache *cache, uint16_t start) {
+    Block *block = malloc(sizeof(Block));
+    if (block == NULL) {
+        return NULL;
+    }
+
+    const uint8_t *memory = cache->cpu->memory;
+    size_t pc = start;
+    block->start = start;
+    block->count = 0;
+    while (block->count < BLOCK_MAX_INSTRUCTIONS && pc < MEMORY_SIZE) {
+        Instruction instruction;
+        // The micro-ops run the undocumented aliases of JMP, CALL and RET like the instructions they alias
+        int length = decodeCanonical(memory, MEMORY_SIZE, pc, &instruction);
+        if (length == 0) {
+            break;
+        }
+
+        MicroOp *op = &block->ops[block->count++];
+        op->opCode = instruction.opCode;
+        op->length = (uint8_t) length;
+        op->cycles = instruction.info->cycles;
+        op->operand = instruction.operand;
+        pc += (size_t) length;
+        if (instruction.info->flow != FLOW_NONE) {
+            break;
+        }
+    }
+    block->end = (uint16_t) pc;
+
+    if (block->count == 0) {
+        free(block);
+        return NULL;
+    }
+    cache->blocks[start] = block;
+    markCode(cache, block);
+    return block;
+}
+
+int blockCacheInit(BlockCache *cache, Cpu *cpu) {
+    memset(cache, 0, sizeof(*cache));
+    cache->cpu = cpu;
+    cache->blocks = calloc(MEMORY_SIZE, sizeof(Block *));
+    if (cache->blocks == NULL) {
+        return -1;
+    }
+    cache->watcherBit = cpuAddWriteWatcher(cpu, invalidateBlocks, cache);
+    if (cache->watcherBit == 0) {
+        free(cache->blocks);
+        return -1;
+    }
+    return 0;
+}
+
+void blockCacheFree(BlockCache *cache) {
+    cpuRemoveWriteWatcher(cache->cpu, cache->watcherBit);
+    for (int address = 0; address < MEMORY_SIZE; address++) {
+        free(cache->blocks[address]);
+    }
+    free(cache->blocks);
+    freeRetiredBlocks(cache);
+}
+
+uint64_t blockCacheRun(BlockCache *cache, uint64_t cycles) {
+    Cpu *cpu = cache->cpu;
+    uint64_t start = cpu->cycles;
+    uint64_t end = start + cycles;
+    while (cpu->cycles < end && !cpu->halted) {
+        Block *block = cache->blocks[cpu->pc];
+        cache->lookups++;
+        if (block != NULL) {
+            cache->hits++;
+        } else {
+            block = translateBlock(cache, cpu->pc);
+            if (block == NULL) {
+                // Instructions wrapping around the end of memory are left to the interpreter
+                cpuStep(cpu);
+                continue;
+            }
+        }
+
+        cache->stop = 0;
+        cpuRunMicroOps(cpu, block->ops, block->count, end, &cache->stop);
+        if (cache->retired != NULL) {
+            freeRetiredBlocks(cache);
+        }
+    }
+    if (cpu->halted && cpu->cycles < end) {
+        cpu->cycles = end;
+    }
+    return cpu->cycles - start;
+}
+
+#pragma clang diagnostic pop
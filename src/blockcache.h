@@ -0,0 +1,47 @@
+#ifndef BLOCKCACHE_H
+#define BLOCKCACHE_H
+
+#include <stdint.h>
+
+#include "cpu.h"
+
+// Longest straight-line run of instructions translated into one block
+#define BLOCK_MAX_INSTRUCTIONS 32
+
+typedef struct Block {
+    uint16_t start;
+    // Address following the last instruction of the block
+    uint16_t end;
+    int count;
+    struct Block *nextRetired;
+    MicroOp ops[BLOCK_MAX_INSTRUCTIONS];
+} Block;
+
+// Caches the instructions of straight-line runs ending in a jump, call, return, restart or halt as blocks of
+// micro-ops, so they are decoded once instead of every time they execute. Writes to memory covered by a block
+// invalidate it.
+typedef struct {
+    Cpu *cpu;
+    // Blocks by start address
+    Block **blocks;
+    // One bit per address covered by a block, to ignore writes to data which shares a page with code
+    uint8_t codeMap[CPU_PAGE_COUNT << CPU_PAGE_SHIFT >> 3];
+    // Invalidated blocks, freed once they are no longer executing
+    Block *retired;
+    int watcherBit;
+    // Set by a write to the running block
+    volatile uint8_t stop;
+    uint64_t lookups;
+    uint64_t hits;
+    uint64_t invalidations;
+} BlockCache;
+
+// Returns 0 on success, -1 if memory or a write watcher couldn't be allocated
+int blockCacheInit(BlockCache *cache, Cpu *cpu);
+
+void blockCacheFree(BlockCache *cache);
+
+// Same as cpuRun(), executing cached blocks
+uint64_t blockCacheRun(BlockCache *cache, uint64_t cycles);
+
+#endif
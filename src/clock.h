@@ -0,0 +1,13 @@
+#ifndef CLOCK_H
+#define CLOCK_H
+
+#include <time.h>
+
+// Seconds on the monotonic clock, to time how long something took
+static inline double clockNow(void) {
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (double) now.tv_sec + (double) now.tv_nsec / 1e9;
+}
+
+#endif
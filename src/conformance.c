@@ -0,0 +1,182 @@
+// Runs CP/M CPU diagnostics such as TST8080, 8080PRE, CPUTEST and 8080EXM as separate jobs on a pool of worker
+// threads, and reports whether each passed and how long it took. A program passes when it returns to CP/M without
+// printing an error. With -J every program also runs on the JIT, which has to print the same and end in the same
+// state as the interpreter.
+// USAGE: conformance [-j THREADS] [-c MAX_CYCLES] [-J] [-v] PROGRAM...
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "clock.h"
+#include "cpm.h"
+#include "jit.h"
+#include "threadpool.h"
+
+#define USAGE "USAGE: conformance [-j THREADS] [-c MAX_CYCLES] [-J] [-v] PROGRAM...\n"
+
+// 8080EXM, the longest of the diagnostics, takes about 24 billion cycles
+#define DEFAULT_MAX_CYCLES 100000000000ULL
+
+typedef struct {
+    const char *fileName;
+    int onJit;
+    uint64_t maxCycles;
+    // The finished system, NULL if it couldn't be set up
+    CpmSystem *system;
+    double elapsed;
+} Run;
+
+static uint64_t runJit(void *context, uint64_t cycles) {
+    return jitRun(context, cycles);
+}
+
+static void runProgram(void *argument) {
+    Run *run = argument;
+    CpmSystem *system = malloc(sizeof(CpmSystem));
+    if (system == NULL || cpmInit(system, run->fileName) != 0) {
+        free(system);
+        return;
+    }
+
+    Jit *jit = NULL;
+    if (run->onJit) {
+        jit = malloc(sizeof(Jit));
+        if (jit == NULL || jitInit(jit, &system->machine.cpu) != 0) {
+            fprintf(stderr, "Failed to allocate the JIT for %s\n", run->fileName);
+            free(jit);
+            free(system);
+            return;
+        }
+        machineSetRunner(&system->machine, runJit, jit);
+    }
+
+    double start = clockNow();
+    cpmRun(system, run->maxCycles);
+    run->elapsed = clockNow() - start;
+
+    if (jit != NULL) {
+        machineSetRunner(&system->machine, NULL, NULL);
+        jitFree(jit);
+        free(jit);
+    }
+    run->system = system;
+}
+
+static const char *verdict(const CpmSystem *system) {
+    if (cpmPassed(system)) {
+        return "PASS";
+    }
+    return system->machine.cpu.halted ? "FAIL" : "TIMEOUT";
+}
+
+// Whether both runs printed the same and ended in the same state
+static int sameResult(const CpmSystem *a, const CpmSystem *b) {
+    const Cpu *x = &a->machine.cpu;
+    const Cpu *y = &b->machine.cpu;
+    return a->outputLength == b->outputLength && strcmp(a->output, b->output) == 0 && x->cycles == y->cycles &&
+           x->instructions == y->instructions && x->pc == y->pc && x->sp == y->sp && x->flags == y->flags &&
+           memcmp(x->registers, y->registers, sizeof(x->registers)) == 0 &&
+           memcmp(a->machine.memory, b->machine.memory, MEMORY_SIZE) == 0;
+}
+
+int main(int argc, char **argv) {
+    int threadCount = threadPoolDefaultSize();
+    uint64_t maxCycles = DEFAULT_MAX_CYCLES;
+    int withJit = 0;
+    int verbose = 0;
+    int option;
+    while ((option = getopt(argc, argv, "j:c:Jv")) != -1) {
+        switch (option) {
+            case 'j':
+                threadCount = atoi(optarg);
+                break;
+            case 'c':
+                maxCycles = strtoull(optarg, NULL, 0);
+                break;
+            case 'J':
+                withJit = 1;
+                break;
+            case 'v':
+                verbose = 1;
+                break;
+            default:
+                fprintf(stderr, USAGE);
+                return 1;
+        }
+    }
+    if (optind == argc || threadCount < 1 || maxCycles == 0) {
+        fprintf(stderr, USAGE);
+        return 1;
+    }
+
+    int programCount = argc - optind;
+    int engineCount = withJit ? 2 : 1;
+    Run *runs = calloc((size_t) (programCount * engineCount), sizeof(Run));
+    if (runs == NULL) {
+        fprintf(stderr, "Cannot allocate %d runs\n", programCount * engineCount);
+        return 1;
+    }
+    ThreadPool pool;
+    if (threadPoolInit(&pool, threadCount) != 0) {
+        free(runs);
+        return 1;
+    }
+
+    double start = clockNow();
+    for (int i = 0; i < programCount * engineCount; i++) {
+        runs[i].fileName = argv[optind + i / engineCount];
+        runs[i].onJit = i % engineCount;
+        runs[i].maxCycles = maxCycles;
+        if (threadPoolSubmit(&pool, runProgram, &runs[i]) != 0) {
+            fprintf(stderr, "Cannot queue %s\n", runs[i].fileName);
+        }
+    }
+    threadPoolWait(&pool);
+    double elapsed = clockNow() - start;
+    threadPoolFree(&pool);
+
+    int passed = 0;
+    int status = 0;
+    for (int i = 0; i < programCount * engineCount; i++) {
+        const Run *run = &runs[i];
+        const CpmSystem *system = run->system;
+        if (system == NULL) {
+            printf("%-7s %s\n", "ERROR", run->fileName);
+            status = 1;
+            continue;
+        }
+        const Cpu *cpu = &system->machine.cpu;
+        printf("%-7s %-24s %-11s %14llu instructions %9.3f s %8.1f MIPS\n", verdict(system), run->fileName,
+               run->onJit ? "jit" : "interpreter", (unsigned long long) cpu->instructions, run->elapsed,
+               (double) cpu->instructions / run->elapsed / 1e6);
+        if (cpmPassed(system)) {
+            passed++;
+        } else {
+            status = 1;
+        }
+        if (system->unsupportedCalls != 0) {
+            printf("        %llu calls of unsupported BDOS functions\n", (unsigned long long) system->unsupportedCalls);
+        }
+        if (run->onJit && runs[i - 1].system != NULL && !sameResult(runs[i - 1].system, system)) {
+            printf("%-7s %-24s the JIT ended differently from the interpreter\n", "DIFFERS", run->fileName);
+            status = 1;
+        }
+        if (verbose) {
+            fwrite(system->output, 1, strlen(system->output), stdout);
+            if (system->outputLength >= CPM_OUTPUT_SIZE) {
+                printf("\n... %zu more characters\n", system->outputLength - (CPM_OUTPUT_SIZE - 1));
+            }
+            printf("\n");
+        }
+    }
+    printf("%d of %d runs passed on %d threads in %.3f s\n", passed, programCount * engineCount, threadCount,
+           elapsed);
+
+    for (int i = 0; i < programCount * engineCount; i++) {
+        free(runs[i].system);
+    }
+    free(runs);
+    return status;
+}
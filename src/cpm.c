@@ -0,0 +1,109 @@
+#include <ctype.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "cpm.h"
+
+// Reads the function from C, returns to CP/M for function 0 and passes the others to callBdos()
+static const uint8_t bdos[] = {
+        0x79,                   // MOV A,C
+        0xB7,                   // ORA A
+        0xCA, 0x00, 0x00,       // JZ 0
+        0xD3, CPM_BDOS_PORT,    // OUT CPM_BDOS_PORT
+        0xC9                    // RET
+};
+
+static void writeConsole(CpmSystem *system, char character) {
+    if (system->outputLength < CPM_OUTPUT_SIZE - 1) {
+        system->output[system->outputLength] = character;
+        system->output[system->outputLength + 1] = '\0';
+    }
+    system->outputLength++;
+}
+
+static void callBdos(void *context, uint8_t port, uint8_t value) {
+    (void) port;
+    (void) value;
+    CpmSystem *system = context;
+    Cpu *cpu = &system->machine.cpu;
+    switch (cpu->registers[REGISTER_C]) {
+        case 2: // Console output of E
+            writeConsole(system, (char) cpu->registers[REGISTER_E]);
+            break;
+        case 9: { // Console output of the string at DE up to a $
+            uint16_t address = (uint16_t) (cpu->registers[REGISTER_D] << 8 | cpu->registers[REGISTER_E]);
+            for (int count = 0; count < MEMORY_SIZE && cpu->memory[address] != '$'; count++, address++) {
+                writeConsole(system, (char) cpu->memory[address]);
+            }
+            break;
+        }
+        default:
+            system->unsupportedCalls++;
+            break;
+    }
+}
+
+int cpmInit(CpmSystem *system, const char *fileName) {
+    memset(system, 0, sizeof(*system));
+    machineInit(&system->machine, CPM_SLICE_CYCLES);
+    machineSetPort(&system->machine, CPM_BDOS_PORT, NULL, callBdos, system);
+
+    uint8_t *memory = system->machine.memory;
+    long size = loadRom(fileName, memory, CPM_PROGRAM_START);
+    if (size < 0) {
+        return -1;
+    }
+    // The program must leave room for the return address on the stack below the BDOS
+    if (size > CPM_BDOS_ADDRESS - 2 - CPM_PROGRAM_START) {
+        fprintf(stderr, "%s is too large for a CP/M program\n", fileName);
+        return -1;
+    }
+
+    // A jump to 0 returns to CP/M, which halts the machine
+    memory[0x0000] = 0x76;
+    memory[CPM_BDOS_ENTRY] = 0xC3;
+    memory[CPM_BDOS_ENTRY + 1] = (uint8_t) CPM_BDOS_ADDRESS;
+    memory[CPM_BDOS_ENTRY + 2] = (uint8_t) (CPM_BDOS_ADDRESS >> 8);
+    memcpy(memory + CPM_BDOS_ADDRESS, bdos, sizeof(bdos));
+
+    // A RET from the program returns to CP/M as well
+    Cpu *cpu = &system->machine.cpu;
+    cpu->sp = CPM_BDOS_ADDRESS - 2;
+    memory[cpu->sp] = 0x00;
+    memory[cpu->sp + 1] = 0x00;
+    cpu->pc = CPM_PROGRAM_START;
+    return 0;
+}
+
+int cpmRun(CpmSystem *system, uint64_t maxCycles) {
+    Cpu *cpu = &system->machine.cpu;
+    uint64_t start = cpu->cycles;
+    // Nothing can interrupt the CPU, so a halted one never goes on
+    while (!cpu->halted && cpu->cycles - start < maxCycles) {
+        machineRunFrame(&system->machine);
+    }
+    return cpmExited(system);
+}
+
+int cpmExited(const CpmSystem *system) {
+    return system->machine.cpu.halted && system->machine.cpu.pc == 0x0001;
+}
+
+static int containsIgnoringCase(const char *text, const char *word) {
+    size_t length = strlen(word);
+    for (; *text != '\0'; text++) {
+        size_t i = 0;
+        while (i < length && toupper((unsigned char) text[i]) == word[i]) {
+            i++;
+        }
+        if (i == length) {
+            return 1;
+        }
+    }
+    return 0;
+}
+
+int cpmPassed(const CpmSystem *system) {
+    return cpmExited(system) && !containsIgnoringCase(system->output, "ERROR") &&
+           !containsIgnoringCase(system->output, "FAIL");
+}
@@ -0,0 +1,52 @@
+#ifndef CPM_H
+#define CPM_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "machine.h"
+
+// Where CP/M loads a .COM program and starts it
+#define CPM_PROGRAM_START 0x0100
+
+// Programs call the BDOS at 5, which jumps to the BDOS at the top of memory. Its address in bytes 6 and 7 also is
+// the end of the memory programs may use, most set their stack there.
+#define CPM_BDOS_ENTRY 0x0005
+#define CPM_BDOS_ADDRESS 0xFF00
+
+// The BDOS hands a call to the emulator through an OUT to this port
+#define CPM_BDOS_PORT 0xFF
+
+// The machine runs in slices of this many cycles, checking between them whether the program has ended
+#define CPM_SLICE_CYCLES (1 << 24)
+
+// Console output kept per program, longer output is counted but cut off
+#define CPM_OUTPUT_SIZE 16384
+
+// Just enough of CP/M for the classic 8080 diagnostics such as TST8080, 8080PRE, CPUTEST and 8080EXM: a .COM
+// program loaded at 0x100, console output through BDOS functions 2 and 9, and a return to CP/M, through a jump to 0
+// or BDOS function 0, which ends the run
+typedef struct {
+    Machine machine;
+    // NUL terminated
+    char output[CPM_OUTPUT_SIZE];
+    // Characters written, including those which didn't fit into output
+    size_t outputLength;
+    // Calls of BDOS functions other than 0, 2 and 9, which are ignored
+    uint64_t unsupportedCalls;
+} CpmSystem;
+
+// Loads the program and sets up the zero page and the BDOS. Returns 0 on success, -1 on failure.
+int cpmInit(CpmSystem *system, const char *fileName);
+
+// Runs the program until it returns to CP/M or maxCycles have passed. Returns 1 if it returned, 0 otherwise.
+int cpmRun(CpmSystem *system, uint64_t maxCycles);
+
+// Whether the program has returned to CP/M
+int cpmExited(const CpmSystem *system);
+
+// Whether the program returned to CP/M without printing ERROR or FAIL in any case, the way the diagnostics report
+// a failed test
+int cpmPassed(const CpmSystem *system);
+
+#endif
@@ -0,0 +1,605 @@
+#pragma clang diagnostic push
+#pragma ide diagnostic ignored "hicpp-signed-bitwise"
+
+#include <string.h>
+
+#include "cpu.h"
+#include "flags.h"
+#include "opcodes.h"
+
+#ifdef CPU_PROFILE
+#include "profile.h"
+#endif
+
+static inline uint8_t readByte(Cpu *cpu, uint16_t address) {
+    return cpu->memory[address];
+}
+
+void cpuNotifyWriteWatchers(Cpu *cpu, uint16_t address, uint8_t watchers) {
+    for (int watcher = 0; watchers != 0; watcher++, watchers >>= 1) {
+        if (watchers & 1) {
+            cpu->watchers[watcher].handler(cpu->watchers[watcher].context, address);
+        }
+    }
+}
+
+void cpuNotifyPageWritten(Cpu *cpu, int page, uint8_t watchers) {
+    if (watchers == 0) {
+        return;
+    }
+    int start = page << CPU_PAGE_SHIFT;
+    for (int address = start; address < start + (1 << CPU_PAGE_SHIFT); address++) {
+        cpuNotifyWriteWatchers(cpu, (uint16_t) address, watchers);
+    }
+}
+
+static inline void writeByte(Cpu *cpu, uint16_t address, uint8_t value) {
+    cpu->memory[address] = value;
+    uint8_t watchers = cpu->watchedPages[address >> CPU_PAGE_SHIFT];
+    if (watchers) {
+        cpuNotifyWriteWatchers(cpu, address, watchers);
+    }
+}
+
+static inline uint16_t readWord(Cpu *cpu, uint16_t address) {
+    return readByte(cpu, address) | (readByte(cpu, (uint16_t) (address + 1)) << 8);
+}
+
+static inline void writeWord(Cpu *cpu, uint16_t address, uint16_t value) {
+    writeByte(cpu, address, (uint8_t) value);
+    writeByte(cpu, (uint16_t) (address + 1), (uint8_t) (value >> 8));
+}
+
+static inline uint8_t fetchByte(Cpu *cpu) {
+    return readByte(cpu, cpu->pc++);
+}
+
+static inline uint16_t fetchWord(Cpu *cpu) {
+    uint16_t word = readWord(cpu, cpu->pc);
+    cpu->pc += 2;
+    return word;
+}
+
+static inline uint16_t readPair(Cpu *cpu, int pair) {
+    if (pair == PAIR_SP) {
+        return cpu->sp;
+    }
+    return cpu->registers[pair * 2] << 8 | cpu->registers[pair * 2 + 1];
+}
+
+static inline void writePair(Cpu *cpu, int pair, uint16_t value) {
+    if (pair == PAIR_SP) {
+        cpu->sp = value;
+    } else {
+        cpu->registers[pair * 2] = (uint8_t) (value >> 8);
+        cpu->registers[pair * 2 + 1] = (uint8_t) value;
+    }
+}
+
+static inline uint8_t readRegister(Cpu *cpu, int reg) {
+    if (reg == REGISTER_M) {
+        return readByte(cpu, readPair(cpu, PAIR_H));
+    }
+    return cpu->registers[reg];
+}
+
+static inline void writeRegister(Cpu *cpu, int reg, uint8_t value) {
+    if (reg == REGISTER_M) {
+        writeByte(cpu, readPair(cpu, PAIR_H), value);
+    } else {
+        cpu->registers[reg] = value;
+    }
+}
+
+static inline void push(Cpu *cpu, uint16_t value) {
+    cpu->sp -= 2;
+    writeWord(cpu, cpu->sp, value);
+}
+
+static inline uint16_t pop(Cpu *cpu) {
+    uint16_t value = readWord(cpu, cpu->sp);
+    cpu->sp += 2;
+    return value;
+}
+
+// Sets S, Z, AC and P from an operation and its result, and CY to carry
+static inline void setFlags(Cpu *cpu, int operation, uint8_t operand, uint8_t value, uint8_t result, uint8_t carry) {
+#if CPU_LAZY_FLAGS
+    cpu->flags = carry;
+    cpu->flagOperation = (uint8_t) operation;
+    cpu->flagOperand = operand;
+    cpu->flagValue = value;
+    cpu->flagResult = result;
+#else
+    cpu->flags = lazyFlags(operation, operand, value, result) | carry;
+#endif
+}
+
+// Computes the flags an operation left to be computed when read
+static inline void updateFlags(Cpu *cpu) {
+#if CPU_LAZY_FLAGS
+    if (cpu->flagOperation) {
+        cpu->flags = (cpu->flags & FLAG_CY) |
+                     lazyFlags(cpu->flagOperation, cpu->flagOperand, cpu->flagValue, cpu->flagResult);
+        cpu->flagOperation = 0;
+    }
+#else
+    (void) cpu;
+#endif
+}
+
+static inline void add(Cpu *cpu, uint8_t value, int carry) {
+    uint8_t accumulator = cpu->registers[REGISTER_A];
+    unsigned int sum = accumulator + value + carry;
+    setFlags(cpu, LAZY_ADD, accumulator, value, (uint8_t) sum, (uint8_t) (sum >> 8));
+    cpu->registers[REGISTER_A] = (uint8_t) sum;
+}
+
+static inline uint8_t subtractWithFlags(Cpu *cpu, uint8_t value, int borrow) {
+    uint8_t accumulator = cpu->registers[REGISTER_A];
+    unsigned int difference = accumulator - value - borrow;
+    setFlags(cpu, LAZY_SUBTRACT, accumulator, value, (uint8_t) difference, (uint8_t) ((difference >> 8) & FLAG_CY));
+    return (uint8_t) difference;
+}
+
+static inline void subtract(Cpu *cpu, uint8_t value, int borrow) {
+    cpu->registers[REGISTER_A] = subtractWithFlags(cpu, value, borrow);
+}
+
+static inline void compare(Cpu *cpu, uint8_t value) {
+    subtractWithFlags(cpu, value, 0);
+}
+
+static inline void logicalAnd(Cpu *cpu, uint8_t value) {
+    uint8_t accumulator = cpu->registers[REGISTER_A];
+    uint8_t result = accumulator & value;
+    setFlags(cpu, LAZY_AND, accumulator, value, result, 0);
+    cpu->registers[REGISTER_A] = result;
+}
+
+static inline void exclusiveOr(Cpu *cpu, uint8_t value) {
+    uint8_t result = cpu->registers[REGISTER_A] ^ value;
+    setFlags(cpu, LAZY_AND, 0, 0, result, 0);
+    cpu->registers[REGISTER_A] = result;
+}
+
+static inline void logicalOr(Cpu *cpu, uint8_t value) {
+    uint8_t result = cpu->registers[REGISTER_A] | value;
+    setFlags(cpu, LAZY_AND, 0, 0, result, 0);
+    cpu->registers[REGISTER_A] = result;
+}
+
+static inline uint8_t increment(Cpu *cpu, uint8_t value) {
+    uint8_t result = value + 1;
+    setFlags(cpu, LAZY_ADD, value, 1, result, cpu->flags & FLAG_CY);
+    return result;
+}
+
+static inline uint8_t decrement(Cpu *cpu, uint8_t value) {
+    uint8_t result = value - 1;
+    setFlags(cpu, LAZY_SUBTRACT, value, 1, result, cpu->flags & FLAG_CY);
+    return result;
+}
+
+static inline void decimalAdjust(Cpu *cpu) {
+    uint8_t accumulator = cpu->registers[REGISTER_A];
+    uint8_t correction = 0;
+    updateFlags(cpu);
+    int carry = cpu->flags & FLAG_CY;
+    if ((accumulator & 0x0F) > 9 || (cpu->flags & FLAG_AC)) {
+        correction |= 0x06;
+    }
+    if ((accumulator >> 4) > 9 || carry || ((accumulator >> 4) == 9 && (accumulator & 0x0F) > 9)) {
+        correction |= 0x60;
+        carry = FLAG_CY;
+    }
+    add(cpu, correction, 0);
+    cpu->flags = (cpu->flags & ~FLAG_CY) | carry;
+}
+
+static inline void addToHL(Cpu *cpu, uint16_t value) {
+    uint32_t result = readPair(cpu, PAIR_H) + value;
+    cpu->flags = (cpu->flags & ~FLAG_CY) | (result >> 16);
+    writePair(cpu, PAIR_H, (uint16_t) result);
+}
+
+static inline void rotateLeft(Cpu *cpu) {
+    uint8_t accumulator = cpu->registers[REGISTER_A];
+    cpu->registers[REGISTER_A] = (accumulator << 1) | (accumulator >> 7);
+    cpu->flags = (cpu->flags & ~FLAG_CY) | (accumulator >> 7);
+}
+
+static inline void rotateRight(Cpu *cpu) {
+    uint8_t accumulator = cpu->registers[REGISTER_A];
+    cpu->registers[REGISTER_A] = (accumulator >> 1) | (accumulator << 7);
+    cpu->flags = (cpu->flags & ~FLAG_CY) | (accumulator & FLAG_CY);
+}
+
+static inline void rotateLeftThroughCarry(Cpu *cpu) {
+    uint8_t accumulator = cpu->registers[REGISTER_A];
+    cpu->registers[REGISTER_A] = (accumulator << 1) | (cpu->flags & FLAG_CY);
+    cpu->flags = (cpu->flags & ~FLAG_CY) | (accumulator >> 7);
+}
+
+static inline void rotateRightThroughCarry(Cpu *cpu) {
+    uint8_t accumulator = cpu->registers[REGISTER_A];
+    cpu->registers[REGISTER_A] = (accumulator >> 1) | ((cpu->flags & FLAG_CY) << 7);
+    cpu->flags = (cpu->flags & ~FLAG_CY) | (accumulator & FLAG_CY);
+}
+
+static inline void pushProgramStatusWord(Cpu *cpu) {
+    updateFlags(cpu);
+    push(cpu, cpu->registers[REGISTER_A] << 8 | cpu->flags);
+}
+
+static inline void popProgramStatusWord(Cpu *cpu) {
+    uint16_t value = pop(cpu);
+    cpu->registers[REGISTER_A] = (uint8_t) (value >> 8);
+    cpu->flags = (value & (FLAG_S | FLAG_Z | FLAG_AC | FLAG_P | FLAG_CY)) | FLAG_ALWAYS_ONE;
+#if CPU_LAZY_FLAGS
+    cpu->flagOperation = 0;
+#endif
+}
+
+static inline void exchangeStackTop(Cpu *cpu) {
+    uint16_t value = readWord(cpu, cpu->sp);
+    writeWord(cpu, cpu->sp, readPair(cpu, PAIR_H));
+    writePair(cpu, PAIR_H, value);
+}
+
+static inline void exchangeDEWithHL(Cpu *cpu) {
+    uint16_t value = readPair(cpu, PAIR_D);
+    writePair(cpu, PAIR_D, readPair(cpu, PAIR_H));
+    writePair(cpu, PAIR_H, value);
+}
+
+// Condition encoded in bits 3-5 of the conditional jumps, calls and returns. S, Z and P only depend on the result
+// of the last operation, which saves computing its AC.
+static inline int checkCondition(Cpu *cpu, int condition) {
+    uint8_t flags = cpu->flags;
+#if CPU_LAZY_FLAGS
+    if (cpu->flagOperation) {
+        flags |= signZeroParityTable[cpu->flagResult];
+    }
+#endif
+    switch (condition) {
+        case 0:
+            return !(flags & FLAG_Z);
+        case 1:
+            return flags & FLAG_Z;
+        case 2:
+            return !(flags & FLAG_CY);
+        case 3:
+            return flags & FLAG_CY;
+        case 4:
+            return !(flags & FLAG_P);
+        case 5:
+            return flags & FLAG_P;
+        case 6:
+            return !(flags & FLAG_S);
+        default:
+            return flags & FLAG_S;
+    }
+}
+
+static inline void call(Cpu *cpu, uint16_t address) {
+    push(cpu, cpu->pc);
+    cpu->pc = address;
+}
+
+static inline void jumpIf(Cpu *cpu, int condition, uint16_t address) {
+    if (condition) {
+        cpu->pc = address;
+    }
+}
+
+static inline void callIf(Cpu *cpu, int condition, uint16_t address) {
+    if (condition) {
+        call(cpu, address);
+        cpu->cycles += CONDITION_MET_CYCLES;
+    }
+}
+
+static inline void returnIf(Cpu *cpu, int condition) {
+    if (condition) {
+        cpu->pc = pop(cpu);
+        cpu->cycles += CONDITION_MET_CYCLES;
+    }
+}
+
+static inline void input(Cpu *cpu, uint8_t port) {
+    cpu->registers[REGISTER_A] = cpu->input ? cpu->input(cpu->ioContext, port) : 0;
+}
+
+static inline void output(Cpu *cpu, uint8_t port) {
+    if (cpu->output) {
+        cpu->output(cpu->ioContext, port, cpu->registers[REGISTER_A]);
+    }
+}
+
+void cpuInit(Cpu *cpu, uint8_t *memory) {
+    memset(cpu, 0, sizeof(*cpu));
+    cpu->flags = FLAG_ALWAYS_ONE;
+    cpu->memory = memory;
+}
+
+int cpuAddWriteWatcher(Cpu *cpu, WriteWatcher handler, void *context) {
+    for (int watcher = 0; watcher < CPU_MAX_WRITE_WATCHERS; watcher++) {
+        if (cpu->watchers[watcher].handler == NULL) {
+            cpu->watchers[watcher].handler = handler;
+            cpu->watchers[watcher].context = context;
+            return 1 << watcher;
+        }
+    }
+    return 0;
+}
+
+void cpuRemoveWriteWatcher(Cpu *cpu, int watcherBit) {
+    for (int page = 0; page < CPU_PAGE_COUNT; page++) {
+        cpu->watchedPages[page] &= ~watcherBit;
+    }
+    for (int watcher = 0; watcher < CPU_MAX_WRITE_WATCHERS; watcher++) {
+        if (watcherBit == 1 << watcher) {
+            cpu->watchers[watcher].handler = NULL;
+            cpu->watchers[watcher].context = NULL;
+        }
+    }
+}
+
+static inline void callTraceHook(Cpu *cpu) {
+    if (cpu->trace != NULL) {
+        updateFlags(cpu);
+        cpu->trace(cpu->traceContext, cpu);
+    }
+}
+
+#ifdef CPU_PROFILE
+
+// Charges the instruction which started at pc and cycle start with the cycles it took, once it has finished
+static inline void profileInstruction(Cpu *cpu, uint16_t pc, uint8_t opCode, uint64_t start) {
+    Profile *profile = cpu->profile;
+    if (profile != NULL) {
+        uint64_t cycles = cpu->cycles - start;
+        profile->opcodeCounts[opCode]++;
+        profile->opcodeCycles[opCode] += cycles;
+        profile->addressCounts[pc]++;
+        profile->addressCycles[pc] += cycles;
+    }
+}
+
+#define PROFILE_STATE uint16_t profilePc = 0; uint64_t profileStart = 0
+#define PROFILE_BEGIN() (profilePc = cpu->pc, profileStart = cpu->cycles)
+#define PROFILE_END(opCode) profileInstruction(cpu, profilePc, opCode, profileStart)
+
+#else
+
+#define PROFILE_STATE
+#define PROFILE_BEGIN() ((void) 0)
+#define PROFILE_END(opCode) ((void) 0)
+
+#endif
+
+// The interpreter loops read operands from the instruction stream
+#define IMMEDIATE8 fetchByte(cpu)
+#define IMMEDIATE16 fetchWord(cpu)
+
+static inline void execute(Cpu *cpu, uint8_t opCode) {
+#define INSTRUCTION(opCode) case opCode:
+#define NEXT break
+    switch (opCode) {
+#include "cpu_instructions.inc"
+    }
+#undef INSTRUCTION
+#undef NEXT
+}
+
+int cpuStep(Cpu *cpu) {
+    if (cpu->halted) {
+        cpu->cycles += opcodeTable[0x00].cycles;
+        return opcodeTable[0x00].cycles;
+    }
+    PROFILE_STATE;
+    uint64_t start = cpu->cycles;
+    callTraceHook(cpu);
+    PROFILE_BEGIN();
+    uint8_t opCode = fetchByte(cpu);
+    cpu->cycles += opcodeTable[opCode].cycles;
+    cpu->instructions++;
+    execute(cpu, opCode);
+    PROFILE_END(opCode);
+    updateFlags(cpu);
+    return (int) (cpu->cycles - start);
+}
+
+uint64_t cpuRunSwitch(Cpu *cpu, uint64_t cycles) {
+    uint64_t start = cpu->cycles;
+    uint64_t end = start + cycles;
+    PROFILE_STATE;
+    while (cpu->cycles < end && !cpu->halted) {
+        callTraceHook(cpu);
+        PROFILE_BEGIN();
+        uint8_t opCode = fetchByte(cpu);
+        cpu->cycles += opcodeTable[opCode].cycles;
+        cpu->instructions++;
+        execute(cpu, opCode);
+        PROFILE_END(opCode);
+    }
+    updateFlags(cpu);
+    if (cpu->halted && cpu->cycles < end) {
+        cpu->cycles = end;
+    }
+    return cpu->cycles - start;
+}
+
+#if CPU_THREADED_DISPATCH
+
+// Addresses of the handler labels, indexed by opcode
+#define THREADED_HANDLERS \
+        &&op_0x00, &&op_0x01, &&op_0x02, &&op_0x03, &&op_0x04, &&op_0x05, &&op_0x06, &&op_0x07, \
+        &&op_0x08, &&op_0x09, &&op_0x0A, &&op_0x0B, &&op_0x0C, &&op_0x0D, &&op_0x0E, &&op_0x0F, \
+        &&op_0x10, &&op_0x11, &&op_0x12, &&op_0x13, &&op_0x14, &&op_0x15, &&op_0x16, &&op_0x17, \
+        &&op_0x18, &&op_0x19, &&op_0x1A, &&op_0x1B, &&op_0x1C, &&op_0x1D, &&op_0x1E, &&op_0x1F, \
+        &&op_0x20, &&op_0x21, &&op_0x22, &&op_0x23, &&op_0x24, &&op_0x25, &&op_0x26, &&op_0x27, \
+        &&op_0x28, &&op_0x29, &&op_0x2A, &&op_0x2B, &&op_0x2C, &&op_0x2D, &&op_0x2E, &&op_0x2F, \
+        &&op_0x30, &&op_0x31, &&op_0x32, &&op_0x33, &&op_0x34, &&op_0x35, &&op_0x36, &&op_0x37, \
+        &&op_0x38, &&op_0x39, &&op_0x3A, &&op_0x3B, &&op_0x3C, &&op_0x3D, &&op_0x3E, &&op_0x3F, \
+        &&op_0x40, &&op_0x41, &&op_0x42, &&op_0x43, &&op_0x44, &&op_0x45, &&op_0x46, &&op_0x47, \
+        &&op_0x48, &&op_0x49, &&op_0x4A, &&op_0x4B, &&op_0x4C, &&op_0x4D, &&op_0x4E, &&op_0x4F, \
+        &&op_0x50, &&op_0x51, &&op_0x52, &&op_0x53, &&op_0x54, &&op_0x55, &&op_0x56, &&op_0x57, \
+        &&op_0x58, &&op_0x59, &&op_0x5A, &&op_0x5B, &&op_0x5C, &&op_0x5D, &&op_0x5E, &&op_0x5F, \
+        &&op_0x60, &&op_0x61, &&op_0x62, &&op_0x63, &&op_0x64, &&op_0x65, &&op_0x66, &&op_0x67, \
+        &&op_0x68, &&op_0x69, &&op_0x6A, &&op_0x6B, &&op_0x6C, &&op_0x6D, &&op_0x6E, &&op_0x6F, \
+        &&op_0x70, &&op_0x71, &&op_0x72, &&op_0x73, &&op_0x74, &&op_0x75, &&op_0x76, &&op_0x77, \
+        &&op_0x78, &&op_0x79, &&op_0x7A, &&op_0x7B, &&op_0x7C, &&op_0x7D, &&op_0x7E, &&op_0x7F, \
+        &&op_0x80, &&op_0x81, &&op_0x82, &&op_0x83, &&op_0x84, &&op_0x85, &&op_0x86, &&op_0x87, \
+        &&op_0x88, &&op_0x89, &&op_0x8A, &&op_0x8B, &&op_0x8C, &&op_0x8D, &&op_0x8E, &&op_0x8F, \
+        &&op_0x90, &&op_0x91, &&op_0x92, &&op_0x93, &&op_0x94, &&op_0x95, &&op_0x96, &&op_0x97, \
+        &&op_0x98, &&op_0x99, &&op_0x9A, &&op_0x9B, &&op_0x9C, &&op_0x9D, &&op_0x9E, &&op_0x9F, \
+        &&op_0xA0, &&op_0xA1, &&op_0xA2, &&op_0xA3, &&op_0xA4, &&op_0xA5, &&op_0xA6, &&op_0xA7, \
+        &&op_0xA8, &&op_0xA9, &&op_0xAA, &&op_0xAB, &&op_0xAC, &&op_0xAD, &&op_0xAE, &&op_0xAF, \
+        &&op_0xB0, &&op_0xB1, &&op_0xB2, &&op_0xB3, &&op_0xB4, &&op_0xB5, &&op_0xB6, &&op_0xB7, \
+        &&op_0xB8, &&op_0xB9, &&op_0xBA, &&op_0xBB, &&op_0xBC, &&op_0xBD, &&op_0xBE, &&op_0xBF, \
+        &&op_0xC0, &&op_0xC1, &&op_0xC2, &&op_0xC3, &&op_0xC4, &&op_0xC5, &&op_0xC6, &&op_0xC7, \
+        &&op_0xC8, &&op_0xC9, &&op_0xCA, &&op_0xCB, &&op_0xCC, &&op_0xCD, &&op_0xCE, &&op_0xCF, \
+        &&op_0xD0, &&op_0xD1, &&op_0xD2, &&op_0xD3, &&op_0xD4, &&op_0xD5, &&op_0xD6, &&op_0xD7, \
+        &&op_0xD8, &&op_0xD9, &&op_0xDA, &&op_0xDB, &&op_0xDC, &&op_0xDD, &&op_0xDE, &&op_0xDF, \
+        &&op_0xE0, &&op_0xE1, &&op_0xE2, &&op_0xE3, &&op_0xE4, &&op_0xE5, &&op_0xE6, &&op_0xE7, \
+        &&op_0xE8, &&op_0xE9, &&op_0xEA, &&op_0xEB, &&op_0xEC, &&op_0xED, &&op_0xEE, &&op_0xEF, \
+        &&op_0xF0, &&op_0xF1, &&op_0xF2, &&op_0xF3, &&op_0xF4, &&op_0xF5, &&op_0xF6, &&op_0xF7, \
+        &&op_0xF8, &&op_0xF9, &&op_0xFA, &&op_0xFB, &&op_0xFC, &&op_0xFD, &&op_0xFE, &&op_0xFF
+
+// Every handler ends with its own indirect jump to the next one, which gives the branch predictor one jump per
+// opcode to learn from instead of the single jump of a switch
+uint64_t cpuRunThreaded(Cpu *cpu, uint64_t cycles) {
+    static const void *const handlers[256] = {THREADED_HANDLERS};
+    uint64_t start = cpu->cycles;
+    uint64_t end = start + cycles;
+    uint8_t opCode = 0;
+    PROFILE_STATE;
+
+#define INSTRUCTION(opCode) op_##opCode:
+#define DISPATCH                                        \
+    do {                                                \
+        if (cpu->cycles >= end || cpu->halted) {        \
+            goto done;                                  \
+        }                                               \
+        callTraceHook(cpu);                             \
+        PROFILE_BEGIN();                                \
+        opCode = fetchByte(cpu);                        \
+        cpu->cycles += opcodeTable[opCode].cycles;      \
+        cpu->instructions++;                            \
+        goto *handlers[opCode];                         \
+    } while (0)
+#define NEXT                                            \
+    do {                                                \
+        PROFILE_END(opCode);                            \
+        DISPATCH;                                       \
+    } while (0)
+
+    DISPATCH;
+#include "cpu_instructions.inc"
+
+#undef INSTRUCTION
+#undef DISPATCH
+#undef NEXT
+
+    done:
+    updateFlags(cpu);
+    if (cpu->halted && cpu->cycles < end) {
+        cpu->cycles = end;
+    }
+    return cpu->cycles - start;
+}
+
+#endif
+
+#undef IMMEDIATE8
+#undef IMMEDIATE16
+
+// Micro-ops carry their operand, pc is moved past the instruction before its handler runs
+#define IMMEDIATE8 ((uint8_t) op->operand)
+#define IMMEDIATE16 (op->operand)
+
+void cpuRunMicroOps(Cpu *cpu, const MicroOp *ops, int count, uint64_t end, const volatile uint8_t *stop) {
+    const MicroOp *op = ops;
+    const MicroOp *last = ops + count;
+    // HLT is always the last micro-op of a block, so only the interpreters check for a halted CPU
+
+    PROFILE_STATE;
+
+#define START                                           \
+    callTraceHook(cpu);                                 \
+    PROFILE_BEGIN();                                    \
+    cpu->pc += op->length;                              \
+    cpu->cycles += op->cycles;                          \
+    cpu->instructions++
+
+#if CPU_THREADED_DISPATCH
+    static const void *const handlers[256] = {THREADED_HANDLERS};
+
+#define INSTRUCTION(opCode) op_##opCode:
+#define NEXT                                                                        \
+    do {                                                                            \
+        PROFILE_END(op->opCode);                                                    \
+        if (++op == last || cpu->cycles >= end || *stop) {                          \
+            updateFlags(cpu);                                                       \
+            return;                                                                 \
+        }                                                                           \
+        START;                                                                      \
+        goto *handlers[op->opCode];                                                 \
+    } while (0)
+
+    START;
+    goto *handlers[op->opCode];
+#include "cpu_instructions.inc"
+
+#else
+
+#define INSTRUCTION(opCode) case opCode:
+#define NEXT break
+
+    for (; op < last; op++) {
+        START;
+        switch (op->opCode) {
+#include "cpu_instructions.inc"
+        }
+        PROFILE_END(op->opCode);
+        if (cpu->cycles >= end || *stop) {
+            break;
+        }
+    }
+    updateFlags(cpu);
+
+#endif
+
+#undef INSTRUCTION
+#undef NEXT
+#undef START
+}
+
+#undef IMMEDIATE8
+#undef IMMEDIATE16
+
+uint64_t cpuRun(Cpu *cpu, uint64_t cycles) {
+#if CPU_THREADED_DISPATCH
+    return cpuRunThreaded(cpu, cycles);
+#else
+    return cpuRunSwitch(cpu, cycles);
+#endif
+}
+
+int cpuInterrupt(Cpu *cpu, int rstNumber) {
+    if (cpu->interruptsEnabled && cpu->instructions == cpu->enableInstruction && !cpu->halted) {
+        cpuStep(cpu);
+    }
+    if (!cpu->interruptsEnabled) {
+        return 0;
+    }
+    cpu->interruptsEnabled = 0;
+    cpu->halted = 0;
+    call(cpu, (uint16_t) (rstNumber * 8));
+    cpu->cycles += opcodeTable[0xC7].cycles;
+    return 1;
+}
+
+#pragma clang diagnostic pop
@@ -0,0 +1,155 @@
+#ifndef CPU_H
+#define CPU_H
+
+#include <stdint.h>
+
+// cpuRun() dispatches with computed gotos (labels as values) where the compiler supports them, and with a switch
+// otherwise. Define CPU_THREADED_DISPATCH as 0 to force the portable switch.
+#ifndef CPU_THREADED_DISPATCH
+#ifdef __GNUC__
+#define CPU_THREADED_DISPATCH 1
+#else
+#define CPU_THREADED_DISPATCH 0
+#endif
+#endif
+
+// Define CPU_LAZY_FLAGS as 1 for interpreters which only record the operands of an instruction setting S, Z, AC and
+// P, and compute those flags when an instruction reads them. The flag tables make computing them about as cheap as
+// recording the operands, and most programs branch on nearly every result, so this is off by default.
+#ifndef CPU_LAZY_FLAGS
+#define CPU_LAZY_FLAGS 0
+#endif
+
+// Register indexes, encoded the same way as the register fields of an opcode
+#define REGISTER_B 0
+#define REGISTER_C 1
+#define REGISTER_D 2
+#define REGISTER_E 3
+#define REGISTER_H 4
+#define REGISTER_L 5
+#define REGISTER_M 6 // The memory byte addressed by H and L, it has no slot in registers[]
+#define REGISTER_A 7
+
+// Register pair indexes, encoded the same way as bits 4-5 of an opcode
+#define PAIR_B 0
+#define PAIR_D 1
+#define PAIR_H 2
+#define PAIR_SP 3
+
+// Condition bits, laid out as in the flag byte pushed by PUSH PSW. Bit 1 is always one.
+#define FLAG_S 0x80
+#define FLAG_Z 0x40
+#define FLAG_AC 0x10
+#define FLAG_P 0x04
+#define FLAG_ALWAYS_ONE 0x02
+#define FLAG_CY 0x01
+
+// Memory is watched for writes in pages of 256 bytes
+#define CPU_PAGE_SHIFT 8
+#define CPU_PAGE_COUNT 256
+#define CPU_MAX_WRITE_WATCHERS 8
+
+typedef struct Cpu Cpu;
+
+// Defining CPU_PROFILE for every file of a build counts executions and cycles per opcode and address into the
+// Profile a CPU points to, see profile.h. Without it the interpreter loops carry no profiling code at all.
+#ifdef CPU_PROFILE
+typedef struct Profile Profile;
+#endif
+
+typedef uint8_t (*InputHandler)(void *context, uint8_t port);
+
+typedef void (*OutputHandler)(void *context, uint8_t port, uint8_t value);
+
+// Called after an instruction wrote to a watched page
+typedef void (*WriteWatcher)(void *context, uint16_t address);
+
+// Called before every instruction executes, with pc still at its opcode
+typedef void (*TraceHook)(void *context, const Cpu *cpu);
+
+// An instruction decoded ahead of execution, see cpuRunMicroOps()
+typedef struct {
+    uint8_t opCode;
+    uint8_t length;
+    uint8_t cycles;
+    uint16_t operand;
+} MicroOp;
+
+struct Cpu {
+    uint8_t registers[8];
+    // Between calls into the CPU all flags are up to date. While it runs, a nonzero flagOperation leaves only CY
+    // up to date here, and S, Z, AC and P are lazyFlags() of the recorded operation, operands and result.
+    uint8_t flags;
+    uint8_t flagOperation;
+    uint8_t flagOperand;
+    uint8_t flagValue;
+    uint8_t flagResult;
+    uint16_t sp;
+    uint16_t pc;
+    uint8_t interruptsEnabled;
+    uint8_t halted;
+    // Value of instructions right after the last EI. Interrupts are only accepted once the instruction following
+    // the EI has run as well, so that e.g. the RET of EI; RET returns before the next interrupt.
+    uint64_t enableInstruction;
+    // Clock cycles and instructions executed since cpuInit()
+    uint64_t cycles;
+    uint64_t instructions;
+    // The 64 KiB address space
+    uint8_t *memory;
+    // IN and OUT handlers, IN reads 0 and OUT is ignored when they are NULL
+    InputHandler input;
+    OutputHandler output;
+    void *ioContext;
+    // Bit n of a page calls watchers[n] on every write to that page
+    uint8_t watchedPages[CPU_PAGE_COUNT];
+    struct {
+        WriteWatcher handler;
+        void *context;
+    } watchers[CPU_MAX_WRITE_WATCHERS];
+    // Not called when NULL
+    TraceHook trace;
+    void *traceContext;
+#ifdef CPU_PROFILE
+    // Not counted when NULL
+    Profile *profile;
+#endif
+};
+
+void cpuInit(Cpu *cpu, uint8_t *memory);
+
+// Executes the instruction at pc and returns the number of cycles it took. A halted CPU idles for the length of a NOP.
+int cpuStep(Cpu *cpu);
+
+// Executes instructions until at least the given number of cycles have passed. A halted CPU idles through the
+// remaining cycles. Returns the number of cycles actually executed.
+uint64_t cpuRun(Cpu *cpu, uint64_t cycles);
+
+// cpuRun() with a specific dispatch loop
+uint64_t cpuRunSwitch(Cpu *cpu, uint64_t cycles);
+
+#if CPU_THREADED_DISPATCH
+uint64_t cpuRunThreaded(Cpu *cpu, uint64_t cycles);
+#endif
+
+// Executes pre-decoded instructions, as if they were at pc, until the last one, until end cycles have passed,
+// the CPU halts or *stop is set. A HLT has to be the last micro-op.
+void cpuRunMicroOps(Cpu *cpu, const MicroOp *ops, int count, uint64_t end, const volatile uint8_t *stop);
+
+// Registers a write watcher. Returns its bit for watchedPages, or 0 when all watchers are taken.
+int cpuAddWriteWatcher(Cpu *cpu, WriteWatcher handler, void *context);
+
+void cpuRemoveWriteWatcher(Cpu *cpu, int watcherBit);
+
+// Calls the write watchers whose bits are set in watchers as if address had just been written. Every write to a
+// watched page, by an interpreter or a JIT translation, reaches its watchers through here.
+void cpuNotifyWriteWatchers(Cpu *cpu, uint16_t address, uint8_t watchers);
+
+// Calls the write watchers whose bits are set in watchers for every address of the page, for memory copied in
+// wholesale instead of written by instructions
+void cpuNotifyPageWritten(Cpu *cpu, int page, uint8_t watchers);
+
+// Performs RST rstNumber if interrupts are enabled. Right after an EI the next instruction is executed first, as
+// the 8080 only enables interrupts once it has run. Returns 1 if the interrupt was accepted, 0 otherwise.
+int cpuInterrupt(Cpu *cpu, int rstNumber);
+
+#endif
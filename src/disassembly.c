@@ -0,0 +1,159 @@
+#pragma clang diagnostic push
+#pragma ide diagnostic ignored "hicpp-signed-bitwise"
+
+#include <string.h>
+
+#include "disassembly.h"
+
+static const char upperHexDigits[] = "0123456789ABCDEF";
+static const char lowerHexDigits[] = "0123456789abcdef";
+
+// Writes value with at least the given number of hex digits
+static char *appendHex(char *out, size_t value, int digits, const char *hexDigits) {
+    while (digits < 16 && (value >> (digits * 4)) != 0) {
+        digits++;
+    }
+    for (int shift = (digits - 1) * 4; shift >= 0; shift -= 4) {
+        *out++ = hexDigits[(value >> shift) & 0xF];
+    }
+    return out;
+}
+
+static char *appendString(char *out, const char *string) {
+    while (*string) {
+        *out++ = *string++;
+    }
+    return out;
+}
+
+// Same layout as printf("%-7s ", mnemonic)
+static char *appendMnemonic(char *out, const char *mnemonic) {
+    char *end = out + 7;
+    out = appendString(out, mnemonic);
+    while (out < end) {
+        *out++ = ' ';
+    }
+    *out++ = ' ';
+    return out;
+}
+
+// Writes the text without the NUL, out needs room for DISASSEMBLY_TEXT_SIZE characters
+static char *appendInstruction(char *out, size_t pc, const Instruction *instruction) {
+    int opCode = instruction->opCode;
+    const OpcodeInfo *info = instruction->info;
+    out = appendHex(out, pc, 4, upperHexDigits);
+    *out++ = ' ';
+    switch (info->operandKind) {
+        case OPERAND_NONE:
+            out = appendString(out, info->mnemonic);
+            break;
+        case OPERAND_REGISTER:
+            out = appendMnemonic(out, info->mnemonic);
+            out = appendString(out, registerName(info->src));
+            break;
+        case OPERAND_DST_REGISTER:
+            out = appendMnemonic(out, info->mnemonic);
+            out = appendString(out, registerName(info->dst));
+            break;
+        case OPERAND_DST_REGISTER_DATA8:
+            out = appendMnemonic(out, info->mnemonic);
+            out = appendString(out, registerName(info->dst));
+            out = appendString(out, ",#$");
+            out = appendHex(out, instruction->operand, 2, lowerHexDigits);
+            break;
+        case OPERAND_MOVE:
+            out = appendMnemonic(out, info->mnemonic);
+            out = appendString(out, registerName(info->dst));
+            *out++ = ',';
+            out = appendString(out, registerName(info->src));
+            break;
+        case OPERAND_PAIR:
+            out = appendMnemonic(out, info->mnemonic);
+            out = appendString(out, registerPairName(opCode));
+            break;
+        case OPERAND_PAIR_DATA16:
+            out = appendMnemonic(out, info->mnemonic);
+            out = appendString(out, registerPairName(opCode));
+            out = appendString(out, ",#$");
+            out = appendHex(out, instruction->operand, 4, upperHexDigits);
+            break;
+        case OPERAND_STACK_PAIR:
+            out = appendMnemonic(out, info->mnemonic);
+            out = appendString(out, stackPairName(opCode));
+            break;
+        case OPERAND_STAX_PAIR:
+            out = appendMnemonic(out, info->mnemonic);
+            out = appendString(out, staxPairName(opCode));
+            break;
+        case OPERAND_DATA8:
+            out = appendMnemonic(out, info->mnemonic);
+            out = appendString(out, "#$");
+            out = appendHex(out, instruction->operand, 2, lowerHexDigits);
+            break;
+        case OPERAND_ADDRESS:
+            out = appendMnemonic(out, info->mnemonic);
+            *out++ = '$';
+            out = appendHex(out, instruction->operand, 4, upperHexDigits);
+            break;
+        case OPERAND_RST:
+            out = appendMnemonic(out, info->mnemonic);
+            *out++ = (char) ('0' + info->dst);
+            break;
+        default:
+            break;
+    }
+    return out;
+}
+
+static char *appendData(char *out, size_t pc, const uint8_t *bytes, int count) {
+    out = appendHex(out, pc, 4, upperHexDigits);
+    *out++ = ' ';
+    out = appendMnemonic(out, "DB");
+    for (int i = 0; i < count; i++) {
+        if (i > 0) {
+            *out++ = ',';
+        }
+        *out++ = '$';
+        out = appendHex(out, bytes[i], 2, lowerHexDigits);
+    }
+    return out;
+}
+
+// Terminates the text written to line and copies it to text unless line is text
+static int finishText(char *text, size_t capacity, char *line, const char *end) {
+    size_t length = (size_t) (end - line);
+    if (line != text) {
+        if (length >= capacity) {
+            return DISASSEMBLY_NO_ROOM;
+        }
+        memcpy(text, line, length);
+    }
+    text[length] = '\0';
+    return (int) length;
+}
+
+int disassembleOne(const uint8_t *code, size_t size, uint16_t pc, Instruction *instruction) {
+    if (pc >= size) {
+        return DISASSEMBLY_TRUNCATED;
+    }
+    int length = decodeInstruction(code, size, pc, instruction);
+    return length == 0 ? DISASSEMBLY_TRUNCATED : length;
+}
+
+int formatInstructionText(char *text, size_t capacity, size_t pc, const Instruction *instruction) {
+    // Large buffers are written directly, small ones only once the length is known
+    char buffer[DISASSEMBLY_TEXT_SIZE];
+    char *line = capacity >= DISASSEMBLY_TEXT_SIZE ? text : buffer;
+    return finishText(text, capacity, line, appendInstruction(line, pc, instruction));
+}
+
+int formatDataText(char *text, size_t capacity, size_t pc, const uint8_t *bytes, int count) {
+    if (count < 1 || count > MAX_DATA_BYTES_PER_LINE) {
+        return DISASSEMBLY_BAD_COUNT;
+    }
+    char buffer[DISASSEMBLY_TEXT_SIZE];
+    char *line = capacity >= DISASSEMBLY_TEXT_SIZE ? text : buffer;
+    return finishText(text, capacity, line, appendData(line, pc, bytes, count));
+}
+
+#pragma clang diagnostic pop
@@ -0,0 +1,32 @@
+#ifndef DISASSEMBLY_H
+#define DISASSEMBLY_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "opcodes.h"
+
+// The functions here keep no state, allocate nothing and never exit, so any number of threads can disassemble at
+// once. They return these instead of a length on failure.
+#define DISASSEMBLY_TRUNCATED (-1) // The code ends before the end of the instruction
+#define DISASSEMBLY_NO_ROOM (-2)   // The text doesn't fit into the buffer
+#define DISASSEMBLY_BAD_COUNT (-3) // A data line of no or more than MAX_DATA_BYTES_PER_LINE bytes
+
+#define MAX_DATA_BYTES_PER_LINE 8
+
+// Enough for the text of any instruction or data line, including the terminating NUL
+#define DISASSEMBLY_TEXT_SIZE 64
+
+// Decodes the instruction at pc of the size bytes of code, e.g. the whole memory of the 8080. Returns its length or
+// DISASSEMBLY_TRUNCATED. Undocumented opcodes decode as one byte with OPERAND_INVALID.
+int disassembleOne(const uint8_t *code, size_t size, uint16_t pc, Instruction *instruction);
+
+// Writes the listing text of the instruction at pc to text, e.g. "0003 JMP     $18D4" without a new line and NUL
+// terminated. Undocumented opcodes only get their address. Returns the length of the text or DISASSEMBLY_NO_ROOM.
+int formatInstructionText(char *text, size_t capacity, size_t pc, const Instruction *instruction);
+
+// Writes a line of up to MAX_DATA_BYTES_PER_LINE data bytes at pc, e.g. "1A5C DB      $00,$3f", the same way.
+// Returns the length of the text, DISASSEMBLY_NO_ROOM or DISASSEMBLY_BAD_COUNT.
+int formatDataText(char *text, size_t capacity, size_t pc, const uint8_t *bytes, int count);
+
+#endif
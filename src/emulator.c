@@ -0,0 +1,140 @@
+// Runs Space Invaders headless for a number of emulated seconds as fast as the host allows and reports the speed.
+// With -p it inserts a coin and starts a one player game, with -t it records a trace of every instruction and with
+// -o it writes the last frame as a PPM picture. Builds with CPU_PROFILE defined write a profile of the run with -P.
+
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+#include "clock.h"
+#include "invaders.h"
+#include "profile.h"
+#include "trace.h"
+#include "video.h"
+
+#ifdef CPU_PROFILE
+#define USAGE "USAGE: emulator [-s SECONDS] [-p] [-t TRACE] [-o PPM] [-P REPORT] MANIFEST\n"
+#define OPTIONS "s:pt:o:P:"
+#else
+#define USAGE "USAGE: emulator [-s SECONDS] [-p] [-t TRACE] [-o PPM] MANIFEST\n"
+#define OPTIONS "s:pt:o:"
+#endif
+
+#ifdef CPU_PROFILE
+static int writeReport(const Profile *profile, const uint8_t *memory, const char *fileName) {
+    int fd = open(fileName, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (fd < 0) {
+        perror(fileName);
+        return -1;
+    }
+    int status = profileWriteReport(profile, memory, fd);
+    if (close(fd) != 0) {
+        perror(fileName);
+        status = -1;
+    }
+    return status;
+}
+#endif
+
+int main(int argc, char **argv) {
+    int seconds = 10;
+    int play = 0;
+    char *traceName = NULL;
+    char *pictureName = NULL;
+#ifdef CPU_PROFILE
+    char *reportName = NULL;
+#endif
+    int option;
+    while ((option = getopt(argc, argv, OPTIONS)) != -1) {
+        switch (option) {
+            case 's':
+                seconds = atoi(optarg);
+                break;
+            case 'p':
+                play = 1;
+                break;
+            case 't':
+                traceName = optarg;
+                break;
+            case 'o':
+                pictureName = optarg;
+                break;
+#ifdef CPU_PROFILE
+            case 'P':
+                reportName = optarg;
+                break;
+#endif
+            default:
+                fprintf(stderr, USAGE);
+                return 1;
+        }
+    }
+    if (optind != argc - 1 || seconds < 0) {
+        fprintf(stderr, USAGE);
+        return 1;
+    }
+
+    static SpaceInvaders invaders;
+    invadersInit(&invaders);
+    Machine *machine = &invaders.machine;
+    if (loadRomSet(argv[optind], machine->memory) < 0) {
+        return 1;
+    }
+    Tracer tracer;
+    if (traceName != NULL) {
+        if (traceOpen(&tracer, traceName, 0) != 0) {
+            return 1;
+        }
+        machine->cpu.trace = traceInstruction;
+        machine->cpu.traceContext = &tracer;
+    }
+#ifdef CPU_PROFILE
+    static Profile profile;
+    if (reportName != NULL) {
+        machine->cpu.profile = &profile;
+    }
+#endif
+    Video video;
+    if (pictureName != NULL && videoInit(&video, &machine->cpu, videoBestKernel()) != 0) {
+        return 1;
+    }
+
+    double start = clockNow();
+    for (uint64_t frame = 0; frame < (uint64_t) seconds * INVADERS_FRAME_RATE; frame++) {
+        if (play) {
+            invaders.inputs[0] = invadersScriptedInputs(frame, 0);
+        }
+        machineRunFrame(machine);
+        if (pictureName != NULL) {
+            videoUpdate(&video);
+        }
+    }
+    double elapsed = clockNow() - start;
+
+    int status = 0;
+    if (traceName != NULL && traceClose(&tracer) != 0) {
+        fprintf(stderr, "Writing the trace failed\n");
+        status = 1;
+    }
+    if (pictureName != NULL) {
+        printf("%.1f video lines converted per frame by the %s kernel\n",
+               (double) video.convertedLines / (double) (video.updates ? video.updates : 1),
+               videoKernelName(video.kernel));
+        if (videoWritePpm(&video, pictureName) != 0) {
+            status = 1;
+        }
+        videoFree(&video);
+    }
+#ifdef CPU_PROFILE
+    if (reportName != NULL && writeReport(&profile, machine->memory, reportName) != 0) {
+        status = 1;
+    }
+#endif
+    printf("%llu frames, %llu instructions in %.3f s\n", (unsigned long long) machine->frames,
+           (unsigned long long) machine->cpu.instructions, elapsed);
+    printf("%.1f MIPS %.1f MHz %.0fx real time\n", (double) machine->cpu.instructions / elapsed / 1e6,
+           (double) machine->cpu.cycles / elapsed / 1e6,
+           (double) machine->cpu.cycles / INVADERS_CLOCK_RATE / elapsed);
+    return status;
+}
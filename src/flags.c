@@ -0,0 +1,24 @@
+#pragma clang diagnostic push
+#pragma ide diagnostic ignored "hicpp-signed-bitwise"
+
+#include "flags.h"
+
+#define PARITY(v) ((((v) ^ (v) >> 1 ^ (v) >> 2 ^ (v) >> 3 ^ (v) >> 4 ^ (v) >> 5 ^ (v) >> 6 ^ (v) >> 7) & 1) ? 0 : FLAG_P)
+#define SIGN_ZERO_PARITY(v) (((v) & FLAG_S) | ((v) == 0 ? FLAG_Z : 0) | PARITY(v) | FLAG_ALWAYS_ONE)
+#define SIGN_ZERO_PARITY_4(v) \
+    SIGN_ZERO_PARITY(v), SIGN_ZERO_PARITY((v) + 1), SIGN_ZERO_PARITY((v) + 2), SIGN_ZERO_PARITY((v) + 3)
+#define SIGN_ZERO_PARITY_16(v) \
+    SIGN_ZERO_PARITY_4(v), SIGN_ZERO_PARITY_4((v) + 4), SIGN_ZERO_PARITY_4((v) + 8), SIGN_ZERO_PARITY_4((v) + 12)
+#define SIGN_ZERO_PARITY_64(v) \
+    SIGN_ZERO_PARITY_16(v), SIGN_ZERO_PARITY_16((v) + 16), SIGN_ZERO_PARITY_16((v) + 32), SIGN_ZERO_PARITY_16((v) + 48)
+
+const uint8_t signZeroParityTable[256] = {
+        SIGN_ZERO_PARITY_64(0), SIGN_ZERO_PARITY_64(64), SIGN_ZERO_PARITY_64(128), SIGN_ZERO_PARITY_64(192)
+};
+
+// The carry into the bit is operand ^ value ^ result, the carry out is the majority of operand, value and carry in.
+// Subtraction adds the complement of the value, so AC is set when no borrow out of bit 3 occurred.
+const uint8_t addAuxCarryTable[8] = {0, 0, FLAG_AC, 0, FLAG_AC, 0, FLAG_AC, FLAG_AC};
+const uint8_t subtractAuxCarryTable[8] = {FLAG_AC, 0, 0, 0, FLAG_AC, FLAG_AC, FLAG_AC, 0};
+
+#pragma clang diagnostic pop
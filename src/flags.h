@@ -0,0 +1,42 @@
+#ifndef FLAGS_H
+#define FLAGS_H
+
+#include <stdint.h>
+
+#include "cpu.h"
+
+// S, Z and P of every result byte, with the always-one bit
+extern const uint8_t signZeroParityTable[256];
+
+// The carry out of bit 3 of an addition only depends on that bit of both operands and of the result. These tables
+// are indexed by (operand << 2) | (value << 1) | result of bit 3, for the addition and for the subtraction, which
+// the 8080 performs as an addition of the two's complement.
+// CY has no table: the ALU computes sums and differences wider than a byte, and bit 8 of the result is the carry or
+// borrow out of bit 7. That takes a shift and a mask, where a table would need bit 7 of three bytes packed first.
+extern const uint8_t addAuxCarryTable[8];
+extern const uint8_t subtractAuxCarryTable[8];
+
+// Packs bit 3 of the three bytes into bits 0-2, the index for AC
+static inline int carryIndex(uint8_t operand, uint8_t value, uint8_t result) {
+    return ((operand & 0x08) >> 1) | ((value & 0x08) >> 2) | ((result & 0x08) >> 3);
+}
+
+// Operations recorded by lazy flag evaluation, see CPU_LAZY_FLAGS. INR and DCR are an addition and a subtraction of
+// 1, ORA and XRA an ANA of two zero operands. 0 means the flags are up to date.
+#define LAZY_ADD 1
+#define LAZY_SUBTRACT 2
+#define LAZY_AND 3
+
+// S, Z, AC and P of a recorded operation
+static inline uint8_t lazyFlags(int operation, uint8_t operand, uint8_t value, uint8_t result) {
+    switch (operation) {
+        case LAZY_ADD:
+            return signZeroParityTable[result] | addAuxCarryTable[carryIndex(operand, value, result)];
+        case LAZY_SUBTRACT:
+            return signZeroParityTable[result] | subtractAuxCarryTable[carryIndex(operand, value, result)];
+        default:
+            return signZeroParityTable[result] | (((operand | value) & 0x08) << 1);
+    }
+}
+
+#endif
@@ -0,0 +1,115 @@
+#pragma clang diagnostic push
+#pragma ide diagnostic ignored "hicpp-signed-bitwise"
+
+#include <errno.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+#include "format.h"
+
+// Flushes a buffer with a file descriptor, doubles the size of one without
+static int makeRoom(OutputBuffer *output) {
+    if (output->fd >= 0) {
+        return flushOutput(output);
+    }
+
+    char *data = realloc(output->data, output->capacity * 2);
+    if (data == NULL) {
+        fprintf(stderr, "Cannot grow the output buffer to %zu bytes\n", output->capacity * 2);
+        return -1;
+    }
+    output->data = data;
+    output->capacity *= 2;
+    return 0;
+}
+
+int initOutputBuffer(OutputBuffer *output, int fd) {
+    output->fd = fd;
+    output->length = 0;
+    output->capacity = fd >= 0 ? OUTPUT_BUFFER_SIZE : GROWING_BUFFER_SIZE;
+    output->data = malloc(output->capacity);
+    if (output->data == NULL) {
+        fprintf(stderr, "Cannot allocate an output buffer of %zu bytes\n", output->capacity);
+        return -1;
+    }
+    return 0;
+}
+
+void freeOutputBuffer(OutputBuffer *output) {
+    free(output->data);
+    output->data = NULL;
+    output->length = 0;
+    output->capacity = 0;
+}
+
+int writeText(int fd, const char *text, size_t length) {
+    size_t written = 0;
+    while (written < length) {
+        ssize_t count = write(fd, text + written, length - written);
+        if (count < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            perror("write");
+            return -1;
+        }
+        written += (size_t) count;
+    }
+    return 0;
+}
+
+int flushOutput(OutputBuffer *output) {
+    if (writeText(output->fd, output->data, output->length) != 0) {
+        return -1;
+    }
+    output->length = 0;
+    return 0;
+}
+
+int formatInstruction(OutputBuffer *output, size_t pc, const Instruction *instruction) {
+    if (output->capacity - output->length < MAX_LINE_LENGTH && makeRoom(output) != 0) {
+        return -1;
+    }
+
+    // MAX_LINE_LENGTH leaves room for the text, whose NUL becomes the new line
+    char *line = output->data + output->length;
+    int length = formatInstructionText(line, output->capacity - output->length, pc, instruction);
+    line[length] = '\n';
+    output->length += (size_t) length + 1;
+    return 0;
+}
+
+int formatComment(OutputBuffer *output, const char *text) {
+    if (output->capacity - output->length < MAX_LINE_LENGTH && makeRoom(output) != 0) {
+        return -1;
+    }
+
+    char *out = output->data + output->length;
+    *out++ = ';';
+    *out++ = ' ';
+    for (int i = 0; i < MAX_LINE_LENGTH - 3 && text[i] != '\0'; i++) {
+        *out++ = text[i];
+    }
+    *out++ = '\n';
+    output->length = (size_t) (out - output->data);
+    return 0;
+}
+
+int formatData(OutputBuffer *output, size_t pc, const uint8_t *bytes, int count) {
+    if (output->capacity - output->length < MAX_LINE_LENGTH && makeRoom(output) != 0) {
+        return -1;
+    }
+
+    char *line = output->data + output->length;
+    int length = formatDataText(line, output->capacity - output->length, pc, bytes, count);
+    if (length < 0) {
+        fprintf(stderr, "Cannot list %d data bytes on one line\n", count);
+        return -1;
+    }
+    line[length] = '\n';
+    output->length += (size_t) length + 1;
+    return 0;
+}
+
+#pragma clang diagnostic pop
@@ -0,0 +1,48 @@
+#ifndef FORMAT_H
+#define FORMAT_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "disassembly.h"
+
+#define OUTPUT_BUFFER_SIZE (64 * 1024)
+
+// Longest line formatInstruction() or formatData() can produce, including the new line
+#define MAX_LINE_LENGTH DISASSEMBLY_TEXT_SIZE
+
+// Initial size of a buffer without a file descriptor, it doubles whenever it fills up
+#define GROWING_BUFFER_SIZE (16 * 1024)
+
+typedef struct {
+    // Text is written to fd whenever the buffer fills up. A buffer with a negative fd keeps all text and grows.
+    int fd;
+    size_t length;
+    size_t capacity;
+    char *data;
+} OutputBuffer;
+
+// Returns 0 on success, -1 if the buffer couldn't be allocated
+int initOutputBuffer(OutputBuffer *output, int fd);
+
+void freeOutputBuffer(OutputBuffer *output);
+
+// Writes length bytes of text to the file descriptor. Returns 0 on success, -1 on failure.
+int writeText(int fd, const char *text, size_t length);
+
+// Writes the buffered text to the file descriptor. Returns 0 on success, -1 on failure.
+int flushOutput(OutputBuffer *output);
+
+// Appends the listing line of the instruction at pc, e.g. "0003 JMP     $18D4". Undocumented opcodes only get their
+// address. Returns 0 on success, -1 if the buffer had to be flushed or grown and that failed.
+int formatInstruction(OutputBuffer *output, size_t pc, const Instruction *instruction);
+
+// Appends "; " and the text as a line, cut off to fit MAX_LINE_LENGTH. Returns 0 on success, -1 if the buffer had to be
+// flushed or grown and that failed.
+int formatComment(OutputBuffer *output, const char *text);
+
+// Appends a line of up to MAX_DATA_BYTES_PER_LINE data bytes at pc, e.g. "1A5C DB      $00,$3f". Returns 0 on
+// success, -1 if the buffer had to be flushed or grown and that failed.
+int formatData(OutputBuffer *output, size_t pc, const uint8_t *bytes, int count);
+
+#endif
@@ -0,0 +1,81 @@
+#pragma clang diagnostic push
+#pragma ide diagnostic ignored "hicpp-signed-bitwise"
+
+#include "invaders.h"
+
+// Input bits wired high on the board
+#define PORT0_DEFAULT 0x0E
+#define PORT1_DEFAULT 0x08
+
+static uint8_t readInputs(void *context, uint8_t port) {
+    SpaceInvaders *invaders = context;
+    switch (port) {
+        case 0:
+            return PORT0_DEFAULT;
+        case 1:
+            return invaders->inputs[0] | PORT1_DEFAULT;
+        case 2:
+            return invaders->inputs[1];
+        case 3:
+            return (uint8_t) (invaders->shiftRegister >> (8 - invaders->shiftOffset));
+        default:
+            return 0;
+    }
+}
+
+static void writeOutputs(void *context, uint8_t port, uint8_t value) {
+    SpaceInvaders *invaders = context;
+    switch (port) {
+        case 2:
+            invaders->shiftOffset = value & 0x7;
+            break;
+        case 3:
+            invaders->sounds[0] = value;
+            break;
+        case 4:
+            invaders->shiftRegister = (uint16_t) ((invaders->shiftRegister >> 8) | (value << 8));
+            break;
+        case 5:
+            invaders->sounds[1] = value;
+            break;
+        default:
+            // Port 6 resets the watchdog, which never runs out while the CPU is emulated
+            break;
+    }
+}
+
+void invadersInit(SpaceInvaders *invaders) {
+    Machine *machine = &invaders->machine;
+    machineInit(machine, INVADERS_FRAME_CYCLES);
+    invaders->inputs[0] = 0;
+    invaders->inputs[1] = 0;
+    invaders->shiftRegister = 0;
+    invaders->shiftOffset = 0;
+    invaders->sounds[0] = 0;
+    invaders->sounds[1] = 0;
+
+    machineSetPort(machine, 0, readInputs, NULL, invaders);
+    machineSetPort(machine, 1, readInputs, NULL, invaders);
+    machineSetPort(machine, 2, readInputs, writeOutputs, invaders);
+    machineSetPort(machine, 3, readInputs, writeOutputs, invaders);
+    machineSetPort(machine, 4, NULL, writeOutputs, invaders);
+    machineSetPort(machine, 5, NULL, writeOutputs, invaders);
+    machineSetPort(machine, 6, NULL, writeOutputs, invaders);
+    machineScheduleInterrupt(machine, INVADERS_FRAME_CYCLES / 2, 1);
+    machineScheduleInterrupt(machine, INVADERS_FRAME_CYCLES, 2);
+}
+
+uint8_t invadersScriptedInputs(uint64_t frame, int play) {
+    if (frame >= INVADERS_COIN_FRAME && frame < INVADERS_COIN_FRAME + INVADERS_PRESS_FRAMES) {
+        return INVADERS_COIN;
+    }
+    if (frame >= INVADERS_START_FRAME && frame < INVADERS_START_FRAME + INVADERS_PRESS_FRAMES) {
+        return INVADERS_P1_START;
+    }
+    if (play && frame >= INVADERS_START_FRAME + INVADERS_PRESS_FRAMES) {
+        return frame % INVADERS_PLAY_PERIOD < INVADERS_PLAY_PERIOD / 2 ? INVADERS_P1_SHOT : INVADERS_P1_RIGHT;
+    }
+    return 0;
+}
+
+#pragma clang diagnostic pop
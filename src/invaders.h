@@ -0,0 +1,53 @@
+#ifndef INVADERS_H
+#define INVADERS_H
+
+#include <stdint.h>
+
+#include "machine.h"
+
+#define INVADERS_CLOCK_RATE 2000000
+#define INVADERS_FRAME_RATE 60
+#define INVADERS_FRAME_CYCLES (INVADERS_CLOCK_RATE / INVADERS_FRAME_RATE)
+
+// Bits of input port 1, a set bit is a pressed button
+#define INVADERS_COIN 0x01
+#define INVADERS_P2_START 0x02
+#define INVADERS_P1_START 0x04
+#define INVADERS_P1_SHOT 0x10
+#define INVADERS_P1_LEFT 0x20
+#define INVADERS_P1_RIGHT 0x40
+
+// Bits of input port 2. The DIP switches select 3 ships and an extra ship at 1500 points by default.
+#define INVADERS_SHIPS_MASK 0x03
+#define INVADERS_TILT 0x04
+#define INVADERS_P2_SHOT 0x10
+#define INVADERS_P2_LEFT 0x20
+#define INVADERS_P2_RIGHT 0x40
+
+// The Taito/Midway Space Invaders board: an 8080 at 2 MHz, RST 1 when the beam reaches the middle of the screen
+// and RST 2 at the start of the vertical blank, and a hardware shift register because the 8080 can only shift by one
+typedef struct {
+    Machine machine;
+    // IN 1 and IN 2, see the INVADERS_ bits
+    uint8_t inputs[2];
+    // Written a byte at a time to its top through OUT 4, read through IN 3 at the bit offset set by OUT 2
+    uint16_t shiftRegister;
+    uint8_t shiftOffset;
+    // Last values written to the sound ports, OUT 3 and OUT 5
+    uint8_t sounds[2];
+} SpaceInvaders;
+
+// Resets the board and wires its ports and interrupts, the ROMs still have to be loaded into machine.memory
+void invadersInit(SpaceInvaders *invaders);
+
+// Frames of the scripted game: a coin is inserted and the one player game started, each button held for
+// INVADERS_PRESS_FRAMES. Playing then fires and moves right in turns of half of INVADERS_PLAY_PERIOD.
+#define INVADERS_COIN_FRAME 60
+#define INVADERS_START_FRAME 120
+#define INVADERS_PRESS_FRAMES 5
+#define INVADERS_PLAY_PERIOD 64
+
+// Input port 1 at a frame of the scripted game, which only inserts a coin and starts the game unless play is set
+uint8_t invadersScriptedInputs(uint64_t frame, int play);
+
+#endif
@@ -0,0 +1,1125 @@
+#pragma clang diagnostic push
+#pragma ide diagnostic ignored "hicpp-signed-bitwise"
+
+#include <stddef.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "jit.h"
+#include "opcodes.h"
+#include "rom.h"
+
+#if JIT_NATIVE
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+
+// Longest distance from the start of a block to its last byte
+#define JIT_MAX_SPAN (JIT_MAX_INSTRUCTIONS * 3)
+
+#define ALL_FLAGS (FLAG_S | FLAG_Z | FLAG_AC | FLAG_P | FLAG_CY)
+
+// The instructions a block may hold, the others are left to the interpreter. EI records the instruction count,
+// which blocks only update when they exit.
+static int isTranslatable(uint8_t opCode) {
+    return opCode != 0x27 && opCode != 0x76 && opCode != 0xD3 && opCode != 0xDB && opCode != 0xFB;
+}
+
+static void freeRetiredBlocks(Jit *jit) {
+    while (jit->retired != NULL) {
+        JitBlock *block = jit->retired;
+        jit->retired = block->nextRetired;
+        free(block);
+    }
+}
+
+// Marks the bytes of the block as code and watches their pages
+static void markCode(Jit *jit, const JitBlock *block) {
+    int end = block->start + (uint16_t) (block->end - block->start);
+    for (int address = block->start; address < end; address++) {
+        jit->codeMap[address >> 3] |= 1 << (address & 0x7);
+        jit->cpu->watchedPages[address >> CPU_PAGE_SHIFT] |= jit->watcherBit;
+    }
+}
+
+// Unmarks the addresses from up to end which no block covers any longer, and stops watching pages left without code
+static void unmarkCode(Jit *jit, int from, int end) {
+    for (int address = from; address < end; address++) {
+        jit->codeMap[address >> 3] &= ~(1 << (address & 0x7));
+    }
+    for (int start = from > JIT_MAX_SPAN ? from - JIT_MAX_SPAN : 0; start < end; start++) {
+        if (jit->blocks[start] != NULL) {
+            markCode(jit, jit->blocks[start]);
+        }
+    }
+
+    const int bytesPerPage = (1 << CPU_PAGE_SHIFT) >> 3;
+    for (int page = from >> CPU_PAGE_SHIFT; page <= (end - 1) >> CPU_PAGE_SHIFT; page++) {
+        const uint8_t *map = jit->codeMap + page * bytesPerPage;
+        int code = 0;
+        for (int i = 0; i < bytesPerPage; i++) {
+            code |= map[i];
+        }
+        if (!code) {
+            jit->cpu->watchedPages[page] &= ~jit->watcherBit;
+        }
+    }
+}
+
+// Retires every block which covers the written address
+static void invalidateBlocks(void *context, uint16_t address) {
+    Jit *jit = context;
+    if (!(jit->codeMap[address >> 3] & (1 << (address & 0x7)))) {
+        return;
+    }
+
+    int from = address + 1;
+    int end = address;
+    for (int offset = 0; offset < JIT_MAX_SPAN && offset <= address; offset++) {
+        JitBlock *block = jit->blocks[address - offset];
+        int blockEnd = block != NULL ? block->start + (uint16_t) (block->end - block->start) : 0;
+        if (address < blockEnd) {
+            jit->blocks[block->start] = NULL;
+            jit->heat[block->start] = 0;
+            block->nextRetired = jit->retired;
+            jit->retired = block;
+            jit->invalidations++;
+            jit->stop = 1;
+            from = block->start < from ? block->start : from;
+            end = blockEnd > end ? blockEnd : end;
+        }
+    }
+    if (from < end) {
+        unmarkCode(jit, from, end);
+    }
+}
+
+#if JIT_NATIVE
+
+// Upper bound of the code generated for one instruction and for a whole block
+#define MAX_INSTRUCTION_CODE 384
+#define MAX_BLOCK_CODE (64 + JIT_MAX_INSTRUCTIONS * MAX_INSTRUCTION_CODE)
+
+enum {
+    RAX, RCX, RDX, RBX, RSP, RBP, RSI, RDI, R8, R9, R10, R11, R12, R13, R14, R15
+};
+
+// Condition codes of Jcc and SETcc
+#define CC_B 0x2
+#define CC_E 0x4
+#define CC_NE 0x5
+
+// While a block runs RBX points to the Cpu, RBP to its memory, and the 8080 registers are zero extended in host
+// registers. None of them survive a call into C, so the slow paths spill them to the Cpu and reload them.
+#define HOST_CPU RBX
+#define HOST_MEMORY RBP
+#define HOST_A R14
+#define HOST_SP R15
+#define HOST_FLAGS RSI
+
+// Indexed by the register field of an opcode, M has no host register
+static const int hostRegisters[8] = {R8, R9, R10, R11, R12, R13, -1, R14};
+
+// The stack frame of a block holds whether a write stopped it, the cycle count to stop at and a temporary which
+// survives the slow path of a write. Its size keeps the stack 16-byte aligned for calls.
+#define FRAME_SIZE 40
+#define FRAME_STOPPED 0
+#define FRAME_END 8
+#define FRAME_TEMPORARY 16
+
+typedef struct {
+    uint8_t *p;
+} Assembler;
+
+typedef struct {
+    Jit *jit;
+    Assembler as;
+    JitBlock *block;
+    // Where a jump back to the start of the block continues, after the prologue
+    uint8_t *top;
+    // Address following the current instruction
+    uint16_t next;
+    // Instructions and cycles up to and including the current instruction
+    int instructions;
+    uint32_t cycles;
+} Translation;
+
+static void emit8(Assembler *as, int value) {
+    *as->p++ = (uint8_t) value;
+}
+
+static void emit16(Assembler *as, int value) {
+    emit8(as, value);
+    emit8(as, value >> 8);
+}
+
+static void emit32(Assembler *as, uint32_t value) {
+    memcpy(as->p, &value, sizeof(value));
+    as->p += sizeof(value);
+}
+
+static void emit64(Assembler *as, uint64_t value) {
+    memcpy(as->p, &value, sizeof(value));
+    as->p += sizeof(value);
+}
+
+// Operand size and REX prefixes, then the opcode. Opcodes above 0xFF take two bytes, e.g. 0x0FB6 for MOVZX.
+static void emitOpcode(Assembler *as, int size, int opcode, int reg, int index, int base) {
+    if (size == 2) {
+        emit8(as, 0x66);
+    }
+    int rex = (size == 8 ? 0x08 : 0) | ((reg & 8) >> 1) | ((index & 8) >> 2) | ((base & 8) >> 3);
+    // Without a REX prefix byte registers 4-7 are AH, CH, DH and BH instead of SPL, BPL, SIL and DIL
+    if (rex != 0 || (size == 1 && ((reg >= 4 && reg < 8) || (base >= 4 && base < 8)))) {
+        emit8(as, 0x40 | rex);
+    }
+    if (opcode > 0xFF) {
+        emit8(as, opcode >> 8);
+    }
+    emit8(as, opcode);
+}
+
+// reg and rm both in registers. Group opcodes take their digit as reg.
+static void emitRegister(Assembler *as, int size, int opcode, int reg, int rm) {
+    emitOpcode(as, size, opcode, reg, 0, rm);
+    emit8(as, 0xC0 | (reg & 7) << 3 | (rm & 7));
+}
+
+// reg and [base + index + displacement], index is -1 without one
+static void emitMemory(Assembler *as, int size, int opcode, int reg, int base, int index, int32_t displacement) {
+    emitOpcode(as, size, opcode, reg, index < 0 ? 0 : index, base);
+    int mod = displacement == 0 && (base & 7) != RBP ? 0 : displacement >= -128 && displacement < 128 ? 1 : 2;
+    if (index < 0 && (base & 7) != RSP) {
+        emit8(as, mod << 6 | (reg & 7) << 3 | (base & 7));
+    } else {
+        emit8(as, mod << 6 | (reg & 7) << 3 | 4);
+        emit8(as, (index < 0 ? 4 : index & 7) << 3 | (base & 7));
+    }
+    if (mod == 1) {
+        emit8(as, displacement);
+    } else if (mod == 2) {
+        emit32(as, (uint32_t) displacement);
+    }
+}
+
+static void emitMove(Assembler *as, int size, int target, int source) {
+    emitRegister(as, size, 0x89, source, target);
+}
+
+static void emitMoveImmediate(Assembler *as, int target, uint32_t value) {
+    if (target & 8) {
+        emit8(as, 0x41);
+    }
+    emit8(as, 0xB8 + (target & 7));
+    emit32(as, value);
+}
+
+static void emitMoveImmediate64(Assembler *as, int target, const volatile void *value) {
+    emit8(as, 0x48 | ((target & 8) >> 3));
+    emit8(as, 0xB8 + (target & 7));
+    emit64(as, (uint64_t) (uintptr_t) value);
+}
+
+// ADD 0, OR 1, ADC 2, SBB 3, AND 4, SUB 5, XOR 6, CMP 7
+static void emitArithmeticImmediate(Assembler *as, int size, int digit, int target, int32_t value) {
+    if (size == 1) {
+        emitRegister(as, 1, 0x80, digit, target);
+        emit8(as, value);
+    } else if (value >= -128 && value < 128) {
+        emitRegister(as, size, 0x83, digit, target);
+        emit8(as, value);
+    } else {
+        emitRegister(as, size, 0x81, digit, target);
+        emit32(as, (uint32_t) value);
+    }
+}
+
+// ROL 0, ROR 1, RCL 2, RCR 3, SHL 4, SHR 5
+static void emitShift(Assembler *as, int size, int digit, int target, int count) {
+    if (count == 1) {
+        emitRegister(as, size, size == 1 ? 0xD0 : 0xD1, digit, target);
+    } else {
+        emitRegister(as, size, size == 1 ? 0xC0 : 0xC1, digit, target);
+        emit8(as, count);
+    }
+}
+
+static void emitZeroExtend16(Assembler *as, int target) {
+    emitRegister(as, 4, 0x0FB7, target, target);
+}
+
+// Returns where the 32-bit displacement goes, a condition below 0 jumps unconditionally
+static uint8_t *emitJumpForward(Assembler *as, int condition) {
+    if (condition < 0) {
+        emit8(as, 0xE9);
+    } else {
+        emit8(as, 0x0F);
+        emit8(as, 0x80 + condition);
+    }
+    uint8_t *displacement = as->p;
+    emit32(as, 0);
+    return displacement;
+}
+
+static void patchJump(uint8_t *displacement, const uint8_t *target) {
+    int32_t distance = (int32_t) (target - (displacement + 4));
+    memcpy(displacement, &distance, sizeof(distance));
+}
+
+static void emitJump(Assembler *as, int condition, const uint8_t *target) {
+    patchJump(emitJumpForward(as, condition), target);
+}
+
+static void emitCall(Assembler *as, const uint8_t *target) {
+    emit8(as, 0xE8);
+    uint8_t *displacement = as->p;
+    emit32(as, 0);
+    patchJump(displacement, target);
+}
+
+// x = register << 8 | register + 1 of a pair, or SP
+static void emitLoadPair(Assembler *as, int pair, int target) {
+    if (pair == PAIR_SP) {
+        emitMove(as, 4, target, HOST_SP);
+        return;
+    }
+    emitMove(as, 4, target, hostRegisters[pair * 2]);
+    emitShift(as, 4, 4, target, 8);
+    emitRegister(as, 4, 0x09, hostRegisters[pair * 2 + 1], target);
+}
+
+// Splits a 16-bit value into a pair, the source register doesn't survive
+static void emitStorePair(Assembler *as, int pair, int source) {
+    if (pair == PAIR_SP) {
+        emitMove(as, 4, HOST_SP, source);
+        return;
+    }
+    emitRegister(as, 4, 0x0FB6, hostRegisters[pair * 2 + 1], source);
+    emitShift(as, 4, 5, source, 8);
+    emitMove(as, 4, hostRegisters[pair * 2], source);
+}
+
+static void emitReadByte(Assembler *as, int target, int address) {
+    emitMemory(as, 4, 0x0FB6, target, HOST_MEMORY, address, 0);
+}
+
+// EAX = address + 1, wrapping around the address space
+static void emitNextAddress(Assembler *as, int address) {
+    if (address != RAX) {
+        emitMove(as, 4, RAX, address);
+    }
+    emitArithmeticImmediate(as, 4, 0, RAX, 1);
+    emitZeroExtend16(as, RAX);
+}
+
+// Stores value at the address in EAX. A write to a watched page calls the watchers and records whether one of them
+// stopped the block. The 8080 registers survive, the other host registers don't.
+static void emitWriteByte(Translation *t, int value) {
+    Assembler *as = &t->as;
+    emitMemory(as, 1, 0x88, value, HOST_MEMORY, RAX, 0);
+    emitMove(as, 4, RDX, RAX);
+    emitShift(as, 4, 5, RDX, CPU_PAGE_SHIFT);
+    emitMemory(as, 1, 0x80, 7, HOST_CPU, RDX, offsetof(Cpu, watchedPages));
+    emit8(as, 0);
+    uint8_t *unwatched = emitJumpForward(as, CC_E);
+
+    emitCall(as, t->jit->spillRoutine);
+    emitMove(as, 8, RDI, HOST_CPU);
+    emitMove(as, 4, RSI, RAX);
+    emitMove(as, 4, RDX, RAX);
+    emitShift(as, 4, 5, RDX, CPU_PAGE_SHIFT);
+    emitMemory(as, 4, 0x0FB6, RDX, HOST_CPU, RDX, offsetof(Cpu, watchedPages));
+    emitMoveImmediate64(as, RAX, (const void *) cpuNotifyWriteWatchers);
+    emitRegister(as, 4, 0xFF, 2, RAX);
+    emitCall(as, t->jit->reloadRoutine);
+    emitMoveImmediate64(as, RAX, &t->jit->stop);
+    emitMemory(as, 4, 0x0FB6, RAX, RAX, -1, 0);
+    emitMemory(as, 1, 0x08, RAX, RSP, -1, FRAME_STOPPED);
+
+    patchJump(unwatched, as->p);
+}
+
+// SP -= 2, then the two bytes are written below the old SP. Either byte may be a constant instead of a register.
+static void emitPush(Translation *t, int high, int low, uint16_t constant) {
+    Assembler *as = &t->as;
+    emitArithmeticImmediate(as, 4, 5, HOST_SP, 2);
+    emitZeroExtend16(as, HOST_SP);
+    emitMove(as, 4, RAX, HOST_SP);
+    if (low < 0) {
+        emitMoveImmediate(as, RCX, constant & 0xFF);
+        low = RCX;
+    }
+    emitWriteByte(t, low);
+    emitNextAddress(as, HOST_SP);
+    if (high < 0) {
+        emitMoveImmediate(as, RCX, constant >> 8);
+        high = RCX;
+    }
+    emitWriteByte(t, high);
+}
+
+// EAX = the word on top of the stack, SP += 2
+static void emitPopWord(Assembler *as) {
+    emitMove(as, 4, RAX, HOST_SP);
+    emitReadByte(as, RCX, RAX);
+    emitNextAddress(as, RAX);
+    emitReadByte(as, RAX, RAX);
+    emitShift(as, 4, 4, RAX, 8);
+    emitRegister(as, 4, 0x09, RCX, RAX);
+    emitArithmeticImmediate(as, 4, 0, HOST_SP, 2);
+    emitZeroExtend16(as, HOST_SP);
+}
+
+// Leaves the block with pc either at address or, when address is negative, in AX
+static void emitExit(Translation *t, uint32_t cycles, int instructions, int address) {
+    Assembler *as = &t->as;
+    if (cycles != 0) {
+        emitMemory(as, 8, 0x81, 0, HOST_CPU, -1, offsetof(Cpu, cycles));
+        emit32(as, cycles);
+    }
+    if (instructions != 0) {
+        emitMemory(as, 8, 0x81, 0, HOST_CPU, -1, offsetof(Cpu, instructions));
+        emit32(as, (uint32_t) instructions);
+    }
+    if (address < 0) {
+        emitMemory(as, 2, 0x89, RAX, HOST_CPU, -1, offsetof(Cpu, pc));
+    } else {
+        emitMemory(as, 2, 0xC7, 0, HOST_CPU, -1, offsetof(Cpu, pc));
+        emit16(as, address);
+    }
+    emitJump(as, -1, t->jit->exitRoutine);
+}
+
+// Leaves the block after the current instruction if one of its writes stopped it
+static void emitStopCheck(Translation *t) {
+    Assembler *as = &t->as;
+    emitMemory(as, 1, 0x80, 7, RSP, -1, FRAME_STOPPED);
+    emit8(as, 0);
+    uint8_t *running = emitJumpForward(as, CC_E);
+    emitExit(t, t->cycles, t->instructions, t->next);
+    patchJump(running, as->p);
+}
+
+// A jump to the start of the block loops in native code for as long as cpuRun() would go on
+static void emitJumpTo(Translation *t, uint16_t target) {
+    Assembler *as = &t->as;
+    if (target != t->block->start) {
+        emitExit(t, t->cycles, t->instructions, target);
+        return;
+    }
+    emitMemory(as, 8, 0x81, 0, HOST_CPU, -1, offsetof(Cpu, cycles));
+    emit32(as, t->cycles);
+    emitMemory(as, 8, 0x81, 0, HOST_CPU, -1, offsetof(Cpu, instructions));
+    emit32(as, (uint32_t) t->instructions);
+    emitMemory(as, 8, 0x8B, RAX, HOST_CPU, -1, offsetof(Cpu, cycles));
+    emitArithmeticImmediate(as, 8, 0, RAX, (int32_t) t->block->leadCycles);
+    emitMemory(as, 8, 0x3B, RAX, RSP, -1, FRAME_END);
+    emitJump(as, CC_B, t->top);
+    emitExit(t, 0, 0, target);
+}
+
+// Jumps when the condition in bits 3-5 of a conditional jump, call or return holds
+static uint8_t *emitConditionTest(Assembler *as, uint8_t opCode) {
+    static const uint8_t conditionFlags[4] = {FLAG_Z, FLAG_CY, FLAG_P, FLAG_S};
+    int condition = OPCODE_DST(opCode);
+    emitRegister(as, 4, 0xF7, 0, HOST_FLAGS);
+    emit32(as, conditionFlags[condition >> 1]);
+    return emitJumpForward(as, (condition & 1) ? CC_NE : CC_E);
+}
+
+// LAHF leaves S, Z, AC, P and CY in AH at their bits of the 8080 flag byte, and bit 1 set like the 8080 does.
+// target must be a register below RSP, as a REX prefix would turn AH into SPL.
+static void emitHostFlags(Assembler *as, int target) {
+    emit8(as, 0x9F);
+    emit8(as, 0x0F);
+    emit8(as, 0xB6);
+    emit8(as, 0xC0 | (target & 7) << 3 | 4);
+}
+
+enum {
+    ALU_ADD, ALU_ADC, ALU_SUB, ALU_SBB, ALU_ANA, ALU_XRA, ALU_ORA, ALU_CMP
+};
+
+// The x86 instruction performing an 8080 ALU operation, as the digit of its immediate form
+static const int aluDigits[8] = {0, 2, 5, 3, 4, 6, 1, 7};
+
+// A op= source, where source is a host register or, when negative, the immediate value
+static void emitArithmetic(Assembler *as, int operation, int source, uint8_t value, int withFlags) {
+    if (operation == ALU_ANA && withFlags) {
+        // AC is the OR of bit 3 of both operands
+        emitMove(as, 4, RDX, HOST_A);
+        if (source < 0) {
+            emitArithmeticImmediate(as, 4, 1, RDX, value);
+        } else {
+            emitRegister(as, 4, 0x09, source, RDX);
+        }
+        emitArithmeticImmediate(as, 4, 4, RDX, 0x08);
+        emitRegister(as, 4, 0x01, RDX, RDX);
+    }
+    if (operation == ALU_ADC || operation == ALU_SBB) {
+        // BT copies CY into the host carry
+        emitRegister(as, 4, 0x0FBA, 4, HOST_FLAGS);
+        emit8(as, 0);
+    }
+    if (source < 0) {
+        emitArithmeticImmediate(as, 1, aluDigits[operation], HOST_A, value);
+    } else {
+        emitRegister(as, 1, aluDigits[operation] << 3, source, HOST_A);
+    }
+    if (!withFlags) {
+        return;
+    }
+
+    emitHostFlags(as, HOST_FLAGS);
+    switch (operation) {
+        case ALU_SUB:
+        case ALU_SBB:
+        case ALU_CMP:
+            // The 8080 sets AC when there is no borrow out of bit 3
+            emitArithmeticImmediate(as, 4, 6, HOST_FLAGS, FLAG_AC);
+            break;
+        case ALU_ANA:
+            emitArithmeticImmediate(as, 4, 4, HOST_FLAGS, (uint8_t) ~FLAG_AC);
+            emitRegister(as, 4, 0x09, RDX, HOST_FLAGS);
+            break;
+        case ALU_XRA:
+        case ALU_ORA:
+            emitArithmeticImmediate(as, 4, 4, HOST_FLAGS, (uint8_t) ~FLAG_AC);
+            break;
+        default:
+            break;
+    }
+}
+
+// Flags of INR and DCR, which keep CY
+static void emitIncrementFlags(Assembler *as, int decrement) {
+    emitHostFlags(as, RDI);
+    emitArithmeticImmediate(as, 4, 4, RDI, (uint8_t) ~FLAG_CY);
+    if (decrement) {
+        emitArithmeticImmediate(as, 4, 6, RDI, FLAG_AC);
+    }
+    emitArithmeticImmediate(as, 4, 4, HOST_FLAGS, FLAG_CY);
+    emitRegister(as, 4, 0x09, RDI, HOST_FLAGS);
+}
+
+// Replaces CY with the bit in the low byte of EAX
+static void emitSetCarry(Assembler *as) {
+    emitArithmeticImmediate(as, 4, 4, HOST_FLAGS, (uint8_t) ~FLAG_CY);
+    emitRegister(as, 4, 0x09, RAX, HOST_FLAGS);
+}
+
+// Flags read and written by a translatable instruction
+static void flagUse(uint8_t opCode, int *reads, int *writes) {
+    *reads = 0;
+    *writes = 0;
+    if ((opCode >= 0x80 && opCode < 0xC0) || (opCode & 0xC7) == 0xC6) {
+        int operation = OPCODE_DST(opCode);
+        *reads = operation == ALU_ADC || operation == ALU_SBB ? FLAG_CY : 0;
+        *writes = ALL_FLAGS;
+    } else if ((opCode & 0xC6) == 0x04 && opCode < 0x40) {
+        *writes = FLAG_S | FLAG_Z | FLAG_AC | FLAG_P;
+    } else if ((opCode & 0xCF) == 0x09 || opCode == 0x07 || opCode == 0x0F || opCode == 0x37) {
+        *writes = FLAG_CY;
+    } else if (opCode == 0x17 || opCode == 0x1F || opCode == 0x3F) {
+        *reads = FLAG_CY;
+        *writes = FLAG_CY;
+    } else if (opCode == 0xF1) {
+        *writes = ALL_FLAGS;
+    } else if (opCode == 0xF5 || opcodeTable[opCode].flow != FLOW_NONE) {
+        *reads = ALL_FLAGS;
+    }
+}
+
+// Whether the instruction writes to memory, after which a block may have to stop
+static int writesMemory(uint8_t opCode) {
+    return (opCode >= 0x70 && opCode < 0x78) || opCode == 0x34 || opCode == 0x35 || opCode == 0x36 ||
+           opCode == 0x02 || opCode == 0x12 || opCode == 0x22 || opCode == 0x32 || (opCode & 0xCF) == 0xC5 ||
+           opCode == 0xE3;
+}
+
+static void translateInstruction(Translation *t, const Instruction *instruction, uint8_t opCode, int withFlags) {
+    Assembler *as = &t->as;
+    uint16_t operand = instruction->operand;
+    int dst = OPCODE_DST(opCode);
+    int src = OPCODE_SRC(opCode);
+    int pair = OPCODE_PAIR(opCode);
+
+    if (opCode >= 0x40 && opCode < 0x80) {
+        if (dst == REGISTER_M) {
+            emitLoadPair(as, PAIR_H, RAX);
+            emitWriteByte(t, hostRegisters[src]);
+            emitStopCheck(t);
+        } else if (src == REGISTER_M) {
+            emitLoadPair(as, PAIR_H, RAX);
+            emitReadByte(as, hostRegisters[dst], RAX);
+        } else if (dst != src) {
+            emitMove(as, 4, hostRegisters[dst], hostRegisters[src]);
+        }
+        return;
+    }
+    if (opCode >= 0x80 && opCode < 0xC0) {
+        int source = hostRegisters[src];
+        if (src == REGISTER_M) {
+            emitLoadPair(as, PAIR_H, RAX);
+            emitReadByte(as, RCX, RAX);
+            source = RCX;
+        }
+        emitArithmetic(as, dst, source, 0, withFlags);
+        return;
+    }
+    if ((opCode & 0xC7) == 0xC6) {
+        emitArithmetic(as, dst, -1, (uint8_t) operand, withFlags);
+        return;
+    }
+    if (opCode < 0x40 && (opCode & 0x06) == 0x04) {
+        // INR and DCR
+        int decrement = opCode & 1;
+        if (dst == REGISTER_M) {
+            emitLoadPair(as, PAIR_H, RAX);
+            emitReadByte(as, RCX, RAX);
+            emitRegister(as, 1, 0xFE, decrement, RCX);
+            if (withFlags) {
+                emitMove(as, 4, RDX, RAX);
+                emitIncrementFlags(as, decrement);
+                emitMove(as, 4, RAX, RDX);
+            }
+            emitWriteByte(t, RCX);
+            emitStopCheck(t);
+        } else {
+            emitRegister(as, 1, 0xFE, decrement, hostRegisters[dst]);
+            if (withFlags) {
+                emitIncrementFlags(as, decrement);
+            }
+        }
+        return;
+    }
+    if (opCode < 0x40 && (opCode & 0x07) == 0x06) {
+        // MVI
+        if (dst == REGISTER_M) {
+            emitLoadPair(as, PAIR_H, RAX);
+            emitMoveImmediate(as, RCX, operand);
+            emitWriteByte(t, RCX);
+            emitStopCheck(t);
+        } else {
+            emitMoveImmediate(as, hostRegisters[dst], operand);
+        }
+        return;
+    }
+
+    switch (opCode & 0xCF) {
+        case 0x01: // LXI
+            if (pair == PAIR_SP) {
+                emitMoveImmediate(as, HOST_SP, operand);
+            } else {
+                emitMoveImmediate(as, hostRegisters[pair * 2], operand >> 8);
+                emitMoveImmediate(as, hostRegisters[pair * 2 + 1], operand & 0xFF);
+            }
+            return;
+        case 0x03: // INX
+        case 0x0B: // DCX
+            emitLoadPair(as, pair, RCX);
+            emitArithmeticImmediate(as, 4, (opCode & 0x08) ? 5 : 0, RCX, 1);
+            emitZeroExtend16(as, RCX);
+            emitStorePair(as, pair, RCX);
+            return;
+        case 0x09: // DAD
+            emitLoadPair(as, PAIR_H, RAX);
+            emitLoadPair(as, pair, RCX);
+            emitRegister(as, 4, 0x01, RCX, RAX);
+            if (withFlags) {
+                emitMove(as, 4, RCX, RAX);
+                emitShift(as, 4, 5, RCX, 16);
+                emitArithmeticImmediate(as, 4, 4, HOST_FLAGS, (uint8_t) ~FLAG_CY);
+                emitRegister(as, 4, 0x09, RCX, HOST_FLAGS);
+            }
+            emitZeroExtend16(as, RAX);
+            emitStorePair(as, PAIR_H, RAX);
+            return;
+        case 0xC1: // POP
+            emitMove(as, 4, RAX, HOST_SP);
+            if (pair == PAIR_SP) {
+                // POP PSW
+                emitReadByte(as, RCX, RAX);
+                emitNextAddress(as, RAX);
+                emitReadByte(as, HOST_A, RAX);
+                emitArithmeticImmediate(as, 4, 4, RCX, ALL_FLAGS);
+                emitArithmeticImmediate(as, 4, 1, RCX, FLAG_ALWAYS_ONE);
+                emitMove(as, 4, HOST_FLAGS, RCX);
+            } else {
+                emitReadByte(as, hostRegisters[pair * 2 + 1], RAX);
+                emitNextAddress(as, RAX);
+                emitReadByte(as, hostRegisters[pair * 2], RAX);
+            }
+            emitArithmeticImmediate(as, 4, 0, HOST_SP, 2);
+            emitZeroExtend16(as, HOST_SP);
+            return;
+        case 0xC5: // PUSH
+            if (pair == PAIR_SP) {
+                emitPush(t, HOST_A, HOST_FLAGS, 0);
+            } else {
+                emitPush(t, hostRegisters[pair * 2], hostRegisters[pair * 2 + 1], 0);
+            }
+            emitStopCheck(t);
+            return;
+        default:
+            break;
+    }
+
+    switch (opCode) {
+        case 0x00: // NOP
+            return;
+        case 0x02: // STAX B
+        case 0x12: // STAX D
+            emitLoadPair(as, pair, RAX);
+            emitWriteByte(t, HOST_A);
+            emitStopCheck(t);
+            return;
+        case 0x0A: // LDAX B
+        case 0x1A: // LDAX D
+            emitLoadPair(as, pair, RAX);
+            emitReadByte(as, HOST_A, RAX);
+            return;
+        case 0x07: // RLC
+        case 0x0F: // RRC
+            emitShift(as, 1, opCode == 0x07 ? 0 : 1, HOST_A, 1);
+            if (withFlags) {
+                emitMove(as, 4, RAX, HOST_A);
+                if (opCode == 0x07) {
+                    emitArithmeticImmediate(as, 4, 4, RAX, FLAG_CY);
+                } else {
+                    emitShift(as, 4, 5, RAX, 7);
+                }
+                emitSetCarry(as);
+            }
+            return;
+        case 0x17: // RAL
+        case 0x1F: // RAR
+            emitRegister(as, 4, 0x0FBA, 4, HOST_FLAGS);
+            emit8(as, 0);
+            emitShift(as, 1, opCode == 0x17 ? 2 : 3, HOST_A, 1);
+            if (withFlags) {
+                emitRegister(as, 1, 0x0F92, 0, RAX);
+                emitRegister(as, 4, 0x0FB6, RAX, RAX);
+                emitSetCarry(as);
+            }
+            return;
+        case 0x22: // SHLD
+            emitMoveImmediate(as, RAX, operand);
+            emitWriteByte(t, hostRegisters[REGISTER_L]);
+            emitMoveImmediate(as, RAX, (uint16_t) (operand + 1));
+            emitWriteByte(t, hostRegisters[REGISTER_H]);
+            emitStopCheck(t);
+            return;
+        case 0x2A: // LHLD
+            emitMemory(as, 4, 0x0FB6, hostRegisters[REGISTER_L], HOST_MEMORY, -1, operand);
+            emitMemory(as, 4, 0x0FB6, hostRegisters[REGISTER_H], HOST_MEMORY, -1, (uint16_t) (operand + 1));
+            return;
+        case 0x2F: // CMA
+            emitRegister(as, 1, 0xF6, 2, HOST_A);
+            return;
+        case 0x32: // STA
+            emitMoveImmediate(as, RAX, operand);
+            emitWriteByte(t, HOST_A);
+            emitStopCheck(t);
+            return;
+        case 0x3A: // LDA
+            emitMemory(as, 4, 0x0FB6, HOST_A, HOST_MEMORY, -1, operand);
+            return;
+        case 0x37: // STC
+            emitArithmeticImmediate(as, 4, 1, HOST_FLAGS, FLAG_CY);
+            return;
+        case 0x3F: // CMC
+            emitArithmeticImmediate(as, 4, 6, HOST_FLAGS, FLAG_CY);
+            return;
+        case 0xE3: // XTHL
+            emitMove(as, 4, RAX, HOST_SP);
+            emitReadByte(as, RCX, RAX);
+            emitNextAddress(as, RAX);
+            emitReadByte(as, RDX, RAX);
+            emitShift(as, 4, 4, RDX, 8);
+            emitRegister(as, 4, 0x09, RDX, RCX);
+            emitMemory(as, 4, 0x89, RCX, RSP, -1, FRAME_TEMPORARY);
+            emitMove(as, 4, RAX, HOST_SP);
+            emitWriteByte(t, hostRegisters[REGISTER_L]);
+            emitNextAddress(as, HOST_SP);
+            emitWriteByte(t, hostRegisters[REGISTER_H]);
+            emitMemory(as, 4, 0x8B, RCX, RSP, -1, FRAME_TEMPORARY);
+            emitStorePair(as, PAIR_H, RCX);
+            emitStopCheck(t);
+            return;
+        case 0xEB: // XCHG
+            emitRegister(as, 4, 0x87, hostRegisters[REGISTER_D], hostRegisters[REGISTER_H]);
+            emitRegister(as, 4, 0x87, hostRegisters[REGISTER_E], hostRegisters[REGISTER_L]);
+            return;
+        case 0xF9: // SPHL
+            emitLoadPair(as, PAIR_H, HOST_SP);
+            return;
+        case 0xF3: // DI
+            emitMemory(as, 1, 0xC6, 0, HOST_CPU, -1, offsetof(Cpu, interruptsEnabled));
+            emit8(as, 0);
+            return;
+        default:
+            break;
+    }
+
+    // The instruction ending the block
+    uint8_t *taken;
+    switch (opCode & 0xC7) {
+        case 0xC2: // Jcc
+            taken = emitConditionTest(as, opCode);
+            emitExit(t, t->cycles, t->instructions, t->next);
+            patchJump(taken, as->p);
+            emitJumpTo(t, operand);
+            return;
+        case 0xC4: // Ccc
+            taken = emitConditionTest(as, opCode);
+            emitExit(t, t->cycles, t->instructions, t->next);
+            patchJump(taken, as->p);
+            emitPush(t, -1, -1, t->next);
+            emitExit(t, t->cycles + CONDITION_MET_CYCLES, t->instructions, operand);
+            return;
+        case 0xC0: // Rcc
+            taken = emitConditionTest(as, opCode);
+            emitExit(t, t->cycles, t->instructions, t->next);
+            patchJump(taken, as->p);
+            emitPopWord(as);
+            emitExit(t, t->cycles + CONDITION_MET_CYCLES, t->instructions, -1);
+            return;
+        case 0xC7: // RST
+            emitPush(t, -1, -1, t->next);
+            emitExit(t, t->cycles, t->instructions, opCode & 0x38);
+            return;
+        default:
+            break;
+    }
+    switch (opCode) {
+        case 0xC3: // JMP
+            emitJumpTo(t, operand);
+            return;
+        case 0xCD: // CALL
+            emitPush(t, -1, -1, t->next);
+            emitExit(t, t->cycles, t->instructions, operand);
+            return;
+        case 0xC9: // RET
+            emitPopWord(as);
+            emitExit(t, t->cycles, t->instructions, -1);
+            return;
+        case 0xE9: // PCHL
+            emitLoadPair(as, PAIR_H, RAX);
+            emitExit(t, t->cycles, t->instructions, -1);
+            return;
+        default:
+            break;
+    }
+}
+
+// Stores the 8080 registers to the Cpu
+static uint8_t *emitSpillRoutine(Assembler *as) {
+    uint8_t *start = as->p;
+    for (int reg = 0; reg < 8; reg++) {
+        if (reg != REGISTER_M) {
+            emitMemory(as, 1, 0x88, hostRegisters[reg], HOST_CPU, -1, (int32_t) offsetof(Cpu, registers) + reg);
+        }
+    }
+    emitMemory(as, 2, 0x89, HOST_SP, HOST_CPU, -1, offsetof(Cpu, sp));
+    emitMemory(as, 1, 0x88, HOST_FLAGS, HOST_CPU, -1, offsetof(Cpu, flags));
+    emit8(as, 0xC3);
+    return start;
+}
+
+// Loads the 8080 registers and the memory pointer from the Cpu
+static uint8_t *emitReloadRoutine(Assembler *as) {
+    uint8_t *start = as->p;
+    emitMemory(as, 8, 0x8B, HOST_MEMORY, HOST_CPU, -1, offsetof(Cpu, memory));
+    for (int reg = 0; reg < 8; reg++) {
+        if (reg != REGISTER_M) {
+            emitMemory(as, 4, 0x0FB6, hostRegisters[reg], HOST_CPU, -1, (int32_t) offsetof(Cpu, registers) + reg);
+        }
+    }
+    emitMemory(as, 4, 0x0FB7, HOST_SP, HOST_CPU, -1, offsetof(Cpu, sp));
+    emitMemory(as, 4, 0x0FB6, HOST_FLAGS, HOST_CPU, -1, offsetof(Cpu, flags));
+    emit8(as, 0xC3);
+    return start;
+}
+
+// Spills the registers and returns from the block to jitRun()
+static uint8_t *emitExitRoutine(Assembler *as, const uint8_t *spillRoutine) {
+    uint8_t *start = as->p;
+    emitCall(as, spillRoutine);
+    emitArithmeticImmediate(as, 8, 0, RSP, FRAME_SIZE);
+    static const int savedRegisters[] = {R15, R14, R13, R12, RBP, RBX};
+    for (size_t i = 0; i < sizeof(savedRegisters) / sizeof(savedRegisters[0]); i++) {
+        if (savedRegisters[i] & 8) {
+            emit8(as, 0x41);
+        }
+        emit8(as, 0x58 + (savedRegisters[i] & 7));
+    }
+    emit8(as, 0xC3);
+    return start;
+}
+
+static void emitPrologue(Translation *t) {
+    Assembler *as = &t->as;
+    static const int savedRegisters[] = {RBX, RBP, R12, R13, R14, R15};
+    for (size_t i = 0; i < sizeof(savedRegisters) / sizeof(savedRegisters[0]); i++) {
+        if (savedRegisters[i] & 8) {
+            emit8(as, 0x41);
+        }
+        emit8(as, 0x50 + (savedRegisters[i] & 7));
+    }
+    emitArithmeticImmediate(as, 8, 5, RSP, FRAME_SIZE);
+    emitMove(as, 8, HOST_CPU, RDI);
+    emitMemory(as, 8, 0x89, RSI, RSP, -1, FRAME_END);
+    emitMemory(as, 1, 0xC6, 0, RSP, -1, FRAME_STOPPED);
+    emit8(as, 0);
+    emitCall(as, t->jit->reloadRoutine);
+    t->top = as->p;
+}
+
+// The arena is never writable and executable at once. Code is emitted into writable pages, which become read-only
+// and executable once it is complete, so only the page shared with the last block has to be made writable again.
+static int protectArena(Jit *jit, size_t from, size_t to, int protection) {
+    size_t pageSize = (size_t) sysconf(_SC_PAGESIZE);
+    from &= ~(pageSize - 1);
+    to = (to + pageSize - 1) & ~(pageSize - 1);
+    return from < to ? mprotect(jit->arena + from, to - from, protection) : 0;
+}
+
+// Starts the arena with the shared routines, dropping every translation. Returns 0 on success, -1 if the arena's
+// protection couldn't be changed, which leaves it full so that nothing is translated until a later reset succeeds.
+static int resetArena(Jit *jit) {
+    jit->arenaUsed = JIT_ARENA_SIZE;
+    if (protectArena(jit, 0, JIT_ARENA_SIZE, PROT_READ | PROT_WRITE) != 0) {
+        return -1;
+    }
+    Assembler as = {jit->arena};
+    jit->spillRoutine = emitSpillRoutine(&as);
+    jit->reloadRoutine = emitReloadRoutine(&as);
+    jit->exitRoutine = emitExitRoutine(&as, jit->spillRoutine);
+    size_t used = ((size_t) (as.p - jit->arena) + 15) & ~(size_t) 15;
+    if (protectArena(jit, 0, used, PROT_READ | PROT_EXEC) != 0) {
+        return -1;
+    }
+    jit->arenaUsed = used;
+    return 0;
+}
+
+static int mapArena(Jit *jit) {
+    void *arena = mmap(NULL, JIT_ARENA_SIZE, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (arena == MAP_FAILED) {
+        return -1;
+    }
+    jit->arena = arena;
+    if (resetArena(jit) != 0) {
+        munmap(arena, JIT_ARENA_SIZE);
+        jit->arena = NULL;
+        return -1;
+    }
+    return 0;
+}
+
+static void unmapArena(Jit *jit) {
+    if (jit->arena != NULL) {
+        munmap(jit->arena, JIT_ARENA_SIZE);
+        jit->arena = NULL;
+    }
+}
+
+// Drops every translation once the arena is full, or when its protection couldn't be changed. Only called between
+// blocks.
+static void flushTranslations(Jit *jit) {
+    for (int address = 0; address < MEMORY_SIZE; address++) {
+        free(jit->blocks[address]);
+        jit->blocks[address] = NULL;
+    }
+    freeRetiredBlocks(jit);
+    memset(jit->codeMap, 0, sizeof(jit->codeMap));
+    for (int page = 0; page < CPU_PAGE_COUNT; page++) {
+        jit->cpu->watchedPages[page] &= ~jit->watcherBit;
+    }
+    resetArena(jit);
+    jit->flushes++;
+}
+
+#else
+
+static int mapArena(Jit *jit) {
+    jit->arena = NULL;
+    return 0;
+}
+
+static void unmapArena(Jit *jit) {
+    (void) jit;
+}
+
+#endif
+
+static JitBlock *translateBlock(Jit *jit, uint16_t start) {
+#if JIT_NATIVE
+    const uint8_t *memory = jit->cpu->memory;
+    Instruction instructions[JIT_MAX_INSTRUCTIONS];
+    int count = 0;
+    size_t pc = start;
+    while (count < JIT_MAX_INSTRUCTIONS && pc < MEMORY_SIZE) {
+        int length = decodeCanonical(memory, MEMORY_SIZE, pc, &instructions[count]);
+        if (length == 0 || !isTranslatable(instructions[count].opCode)) {
+            break;
+        }
+        pc += length;
+        if (opcodeTable[instructions[count++].opCode].flow != FLOW_NONE) {
+            break;
+        }
+    }
+    if (count == 0) {
+        return NULL;
+    }
+
+    // Flags are live at the end of the block and after every write, where the block may stop
+    int liveAfter[JIT_MAX_INSTRUCTIONS];
+    int live = ALL_FLAGS;
+    for (int i = count - 1; i >= 0; i--) {
+        uint8_t opCode = instructions[i].opCode;
+        if (writesMemory(opCode)) {
+            live = ALL_FLAGS;
+        }
+        liveAfter[i] = live;
+        int reads, writes;
+        flagUse(opCode, &reads, &writes);
+        live = (live & ~writes) | reads;
+    }
+
+    JitBlock *block = malloc(sizeof(JitBlock));
+    if (block == NULL) {
+        return NULL;
+    }
+    if (JIT_ARENA_SIZE - jit->arenaUsed < MAX_BLOCK_CODE) {
+        flushTranslations(jit);
+    }
+    // The page the last block ended in is executable
+    size_t begin = jit->arenaUsed;
+    if (JIT_ARENA_SIZE - begin < MAX_BLOCK_CODE || protectArena(jit, begin, begin + 1, PROT_READ | PROT_WRITE) != 0) {
+        free(block);
+        return NULL;
+    }
+    block->start = start;
+    block->end = (uint16_t) pc;
+    block->count = count;
+    block->leadCycles = 0;
+    for (int i = 0; i < count - 1; i++) {
+        block->leadCycles += instructions[i].info->cycles;
+    }
+
+    Translation t = {jit, {jit->arena + jit->arenaUsed}, block, NULL, start, 0, 0};
+    block->code = (JitCode) (void *) t.as.p;
+    emitPrologue(&t);
+    for (int i = 0; i < count; i++) {
+        uint8_t opCode = instructions[i].opCode;
+        int reads, writes;
+        flagUse(opCode, &reads, &writes);
+        t.next = (uint16_t) (t.next + instructions[i].info->length);
+        t.instructions++;
+        t.cycles += instructions[i].info->cycles;
+        translateInstruction(&t, &instructions[i], opCode, (writes & liveAfter[i]) != 0);
+    }
+    if (opcodeTable[instructions[count - 1].opCode].flow == FLOW_NONE) {
+        emitExit(&t, t.cycles, t.instructions, t.next);
+    }
+    jit->arenaUsed = ((size_t) (t.as.p - jit->arena) + 15) & ~(size_t) 15;
+    if (protectArena(jit, begin, jit->arenaUsed, PROT_READ | PROT_EXEC) != 0) {
+        // Earlier blocks may share the first page, which is no longer executable
+        free(block);
+        flushTranslations(jit);
+        return NULL;
+    }
+
+    markCode(jit, block);
+    jit->blocks[start] = block;
+    jit->translations++;
+    return block;
+#else
+    (void) jit;
+    (void) start;
+    return NULL;
+#endif
+}
+
+// Interprets up to and including the next instruction which ends a block or can't be translated, like cpuRun()
+static void interpretBlock(Cpu *cpu, uint64_t end) {
+    uint8_t opCode;
+    do {
+        opCode = cpu->memory[cpu->pc];
+        cpuStep(cpu);
+    } while (opcodeTable[opCode].flow == FLOW_NONE && isTranslatable(opCode) && cpu->cycles < end && !cpu->halted);
+}
+
+int jitInit(Jit *jit, Cpu *cpu) {
+    memset(jit, 0, sizeof(*jit));
+    jit->cpu = cpu;
+    jit->hotThreshold = JIT_HOT_THRESHOLD;
+    jit->blocks = calloc(MEMORY_SIZE, sizeof(JitBlock *));
+    jit->heat = calloc(MEMORY_SIZE, 1);
+    if (jit->blocks == NULL || jit->heat == NULL || mapArena(jit) != 0) {
+        free(jit->blocks);
+        free(jit->heat);
+        return -1;
+    }
+    jit->watcherBit = cpuAddWriteWatcher(cpu, invalidateBlocks, jit);
+    if (jit->watcherBit == 0) {
+        unmapArena(jit);
+        free(jit->blocks);
+        free(jit->heat);
+        return -1;
+    }
+    return 0;
+}
+
+void jitFree(Jit *jit) {
+    cpuRemoveWriteWatcher(jit->cpu, jit->watcherBit);
+    for (int address = 0; address < MEMORY_SIZE; address++) {
+        free(jit->blocks[address]);
+    }
+    free(jit->blocks);
+    free(jit->heat);
+    freeRetiredBlocks(jit);
+    unmapArena(jit);
+}
+
+uint64_t jitRun(Jit *jit, uint64_t cycles) {
+    Cpu *cpu = jit->cpu;
+#ifdef CPU_PROFILE
+    if (cpu->profile != NULL) {
+        return cpuRun(cpu, cycles);
+    }
+#endif
+    if (cpu->trace != NULL) {
+        return cpuRun(cpu, cycles);
+    }
+
+    uint64_t start = cpu->cycles;
+    uint64_t end = start + cycles;
+    while (cpu->cycles < end && !cpu->halted) {
+        JitBlock *block = jit->blocks[cpu->pc];
+        if (block == NULL && ++jit->heat[cpu->pc] >= jit->hotThreshold) {
+            jit->heat[cpu->pc] = 0;
+            block = translateBlock(jit, cpu->pc);
+        }
+
+        // A block which could pass end before its last instruction is interpreted, to stop where cpuRun() would
+        if (block != NULL && cpu->cycles + block->leadCycles < end) {
+            jit->stop = 0;
+            block->code(cpu, end);
+            jit->nativeRuns++;
+        } else {
+            interpretBlock(cpu, end);
+        }
+        if (jit->retired != NULL) {
+            freeRetiredBlocks(jit);
+        }
+    }
+    if (cpu->halted && cpu->cycles < end) {
+        cpu->cycles = end;
+    }
+    return cpu->cycles - start;
+}
+
+#pragma clang diagnostic pop
@@ -0,0 +1,79 @@
+#ifndef JIT_H
+#define JIT_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "cpu.h"
+
+// Native code is only generated for x86-64 on Unix, jitRun() interprets everywhere else
+#if defined(__GNUC__) && defined(__x86_64__) && defined(__unix__)
+#define JIT_NATIVE 1
+#else
+#define JIT_NATIVE 0
+#endif
+
+// Longest straight-line run of instructions translated into one block
+#define JIT_MAX_INSTRUCTIONS 32
+
+// Times a block start is reached before it is translated
+#define JIT_HOT_THRESHOLD 16
+
+// Memory for the translations, it is emptied when it fills up. It is writable while code is emitted and read-only
+// and executable afterwards, never both at once.
+#define JIT_ARENA_SIZE (4 * 1024 * 1024)
+
+// Called with the cycle count execution has to stop at
+typedef void (*JitCode)(Cpu *cpu, uint64_t end);
+
+typedef struct JitBlock {
+    uint16_t start;
+    // Address following the last instruction of the block
+    uint16_t end;
+    int count;
+    // Cycles of all instructions but the last. The block only runs when this many cycles later it may still go on,
+    // so that it never has to stop in the middle.
+    uint32_t leadCycles;
+    JitCode code;
+    struct JitBlock *nextRetired;
+} JitBlock;
+
+// Translates the straight-line runs the interpreter enters often into x86-64 code. The 8080 registers live in
+// host registers while a block runs, and an ALU instruction only computes the flags a later instruction of the
+// block can read. Writes to memory covered by a block invalidate it. IN, OUT, DAA, EI and HLT aren't translated, a
+// block ends before them and the interpreter executes them.
+typedef struct {
+    Cpu *cpu;
+    // Blocks by start address
+    JitBlock **blocks;
+    // How often every address was reached as the start of a block which isn't translated
+    uint8_t *heat;
+    int hotThreshold;
+    // One bit per address covered by a block, to ignore writes to data which shares a page with code
+    uint8_t codeMap[CPU_PAGE_COUNT << CPU_PAGE_SHIFT >> 3];
+    // Invalidated blocks, freed once they are no longer executing
+    JitBlock *retired;
+    uint8_t *arena;
+    size_t arenaUsed;
+    // Shared routines at the start of the arena
+    uint8_t *spillRoutine;
+    uint8_t *reloadRoutine;
+    uint8_t *exitRoutine;
+    int watcherBit;
+    // Set by a write to a translated block, the running block stops after the writing instruction
+    volatile uint8_t stop;
+    uint64_t translations;
+    uint64_t invalidations;
+    uint64_t flushes;
+    uint64_t nativeRuns;
+} Jit;
+
+// Returns 0 on success, -1 if memory or a write watcher couldn't be allocated
+int jitInit(Jit *jit, Cpu *cpu);
+
+void jitFree(Jit *jit);
+
+// Same as cpuRun(), executing translated blocks. A CPU with a trace hook or a profile is only interpreted.
+uint64_t jitRun(Jit *jit, uint64_t cycles);
+
+#endif
@@ -0,0 +1,80 @@
+#include <string.h>
+
+#include "machine.h"
+
+static uint8_t readPort(void *context, uint8_t port) {
+    Machine *machine = context;
+    InputHandler read = machine->readers[port];
+    return read ? read(machine->readerContexts[port], port) : 0;
+}
+
+static void writePort(void *context, uint8_t port, uint8_t value) {
+    Machine *machine = context;
+    OutputHandler write = machine->writers[port];
+    if (write) {
+        write(machine->writerContexts[port], port, value);
+    }
+}
+
+// Runs the CPU until it has reached the given cycle, the last instruction may end past it
+static void runUntil(Machine *machine, uint64_t cycle) {
+    if (machine->cpu.cycles >= cycle) {
+        return;
+    }
+    if (machine->run != NULL) {
+        machine->run(machine->runContext, cycle - machine->cpu.cycles);
+    } else {
+        cpuRun(&machine->cpu, cycle - machine->cpu.cycles);
+    }
+}
+
+void machineInit(Machine *machine, uint32_t frameCycles) {
+    memset(machine, 0, sizeof(*machine));
+    cpuInit(&machine->cpu, machine->memory);
+    machine->cpu.input = readPort;
+    machine->cpu.output = writePort;
+    machine->cpu.ioContext = machine;
+    machine->frameCycles = frameCycles;
+}
+
+void machineSetPort(Machine *machine, uint8_t port, InputHandler read, OutputHandler write, void *context) {
+    machine->readers[port] = read;
+    machine->readerContexts[port] = context;
+    machine->writers[port] = write;
+    machine->writerContexts[port] = context;
+}
+
+void machineSetRunner(Machine *machine, CpuRunner run, void *context) {
+    machine->run = run;
+    machine->runContext = context;
+}
+
+int machineScheduleInterrupt(Machine *machine, uint32_t cycle, int rstNumber) {
+    if (cycle > machine->frameCycles || machine->interruptCount == MACHINE_MAX_INTERRUPTS) {
+        return -1;
+    }
+
+    int index = machine->interruptCount++;
+    for (; index > 0 && machine->interrupts[index - 1].cycle > cycle; index--) {
+        machine->interrupts[index] = machine->interrupts[index - 1];
+    }
+    machine->interrupts[index].cycle = cycle;
+    machine->interrupts[index].rstNumber = (uint8_t) rstNumber;
+    return 0;
+}
+
+void machineRunFrame(Machine *machine) {
+    for (int i = 0; i < machine->interruptCount; i++) {
+        runUntil(machine, machine->frameStart + machine->interrupts[i].cycle);
+        cpuInterrupt(&machine->cpu, machine->interrupts[i].rstNumber);
+    }
+    machine->frameStart += machine->frameCycles;
+    runUntil(machine, machine->frameStart);
+    machine->frames++;
+}
+
+void machineRunFrames(Machine *machine, uint64_t frames) {
+    for (uint64_t frame = 0; frame < frames; frame++) {
+        machineRunFrame(machine);
+    }
+}
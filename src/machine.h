@@ -0,0 +1,62 @@
+#ifndef MACHINE_H
+#define MACHINE_H
+
+#include <stdint.h>
+
+#include "cpu.h"
+#include "rom.h"
+
+#define MACHINE_PORT_COUNT 256
+#define MACHINE_MAX_INTERRUPTS 8
+
+// Runs the CPU for at least the given number of cycles like cpuRun(), e.g. through a JIT or a block cache
+typedef uint64_t (*CpuRunner)(void *context, uint64_t cycles);
+
+typedef struct {
+    // Cycles after the start of the frame, frameCycles itself fires at the end of the frame
+    uint32_t cycle;
+    uint8_t rstNumber;
+} ScheduledInterrupt;
+
+// A CPU with its own memory, I/O ports dispatched to per-port handlers and interrupts requested at fixed cycles
+// of every frame. Time only advances with the CPU's cycle counter, so runs are deterministic and go as fast as the
+// host allows. The CPU points into the machine, which must not be moved once initialized.
+typedef struct {
+    Cpu cpu;
+    uint8_t memory[MEMORY_SIZE];
+    InputHandler readers[MACHINE_PORT_COUNT];
+    void *readerContexts[MACHINE_PORT_COUNT];
+    OutputHandler writers[MACHINE_PORT_COUNT];
+    void *writerContexts[MACHINE_PORT_COUNT];
+    uint32_t frameCycles;
+    // Sorted by cycle
+    ScheduledInterrupt interrupts[MACHINE_MAX_INTERRUPTS];
+    int interruptCount;
+    // cpuRun() when NULL
+    CpuRunner run;
+    void *runContext;
+    // CPU cycle the current frame started at
+    uint64_t frameStart;
+    uint64_t frames;
+} Machine;
+
+// Clears memory and resets the CPU. Unhandled ports read 0 and ignore writes.
+void machineInit(Machine *machine, uint32_t frameCycles);
+
+// Sets the handlers of a port, either can be NULL
+void machineSetPort(Machine *machine, uint8_t port, InputHandler read, OutputHandler write, void *context);
+
+// Runs the CPU through run(context, cycles) instead of cpuRun(), or through cpuRun() again when run is NULL
+void machineSetRunner(Machine *machine, CpuRunner run, void *context);
+
+// Requests RST rstNumber at the given cycle of every frame. Returns 0 on success, -1 when the cycle is past the
+// end of the frame or the timeline is full.
+int machineScheduleInterrupt(Machine *machine, uint32_t cycle, int rstNumber);
+
+// Runs one frame, requesting every scheduled interrupt once the CPU has reached its cycle. An interrupt
+// requested while interrupts are disabled is lost.
+void machineRunFrame(Machine *machine);
+
+void machineRunFrames(Machine *machine, uint64_t frames);
+
+#endif
@@ -0,0 +1,488 @@
+#pragma clang diagnostic push
+#pragma ide diagnostic ignored "hicpp-signed-bitwise"
+
+#include <string.h>
+
+#include "opcodes.h"
+
+#define FLOW(opCode) \
+    (((opCode) & 0xC7) == 0xC0 ? FLOW_CONDITIONAL_RETURN : \
+     ((opCode) & 0xC7) == 0xC2 ? FLOW_CONDITIONAL_JUMP : \
+     ((opCode) & 0xC7) == 0xC4 ? FLOW_CONDITIONAL_CALL : \
+     ((opCode) & 0xC7) == 0xC7 ? FLOW_RESTART : \
+     ((opCode) & 0xEF) == 0xC9 ? FLOW_RETURN : \
+     ((opCode) & 0xF7) == 0xC3 ? FLOW_JUMP : \
+     ((opCode) & 0xCF) == 0xCD ? FLOW_CALL : \
+     (opCode) == 0xE9 ? FLOW_INDIRECT_JUMP : \
+     (opCode) == 0x76 ? FLOW_HALT : FLOW_NONE)
+
+#define OP(opCode, mnemonic, length, operandKind, cycles) \
+    [opCode] = {mnemonic, length, operandKind, OPCODE_DST(opCode), OPCODE_SRC(opCode), OPCODE_PAIR(opCode), cycles, \
+                FLOW(opCode)}
+
+// The undocumented opcodes still execute as an alias of NOP, JMP, RET or CALL and take its cycles
+#define INVALID(opCode, cycles) OP(opCode, NULL, 1, OPERAND_INVALID, cycles)
+
+// Eight consecutive opcodes which only differ in the register encoded in bits 0-2,
+// the one operating on memory (M) takes memoryCycles
+#define REGISTER_ROW(base, mnemonic, operandKind, cycles, memoryCycles) \
+    OP((base) + 0, mnemonic, 1, operandKind, cycles), OP((base) + 1, mnemonic, 1, operandKind, cycles), \
+    OP((base) + 2, mnemonic, 1, operandKind, cycles), OP((base) + 3, mnemonic, 1, operandKind, cycles), \
+    OP((base) + 4, mnemonic, 1, operandKind, cycles), OP((base) + 5, mnemonic, 1, operandKind, cycles), \
+    OP((base) + 6, mnemonic, 1, operandKind, memoryCycles), OP((base) + 7, mnemonic, 1, operandKind, cycles)
+
+// Documentation for some of instructions has been copied from the Intel's 8080 Assembly Language Programming Manual
+const OpcodeInfo opcodeTable[256] = {
+        // No operation
+        OP(0x00, "NOP", 1, OPERAND_NONE, 4),
+        // Format: LXI rp,data
+        // rp can be B, D, H, or SP
+        // data is a 16-bit quantity.
+        // Loads 2 bytes immediate data into the register pair.
+        // The higher 8 bits of the immediate data is loaded into the first register of the pair (e.g. C),
+        // while the lower 8 bits of the immediate data is loaded into the second register of the pair (e.g. D).
+        OP(0x01, "LXI", 3, OPERAND_PAIR_DATA16, 10),
+        // Format: STAX rp
+        // rp can be B or C.
+        // Stores the content of the accumulator to the memory location addressed by the registers B and C,
+        // or C and D.
+        OP(0x02, "STAX", 1, OPERAND_STAX_PAIR, 7),
+        // Format: INX rp
+        // rp can be B, D, H, or SP
+        // Increments the 16 bit data held in the specified register by one.
+        OP(0x03, "INX", 1, OPERAND_PAIR, 5),
+        // Format: INR reg
+        // reg can be B, C, D, E, H, L, M (memory), or A
+        // Flags affected: Z, S, P, AC
+        // Increments the specified register or memory location by one.
+        // If a memory reference is specified, then the memory byte addressed by H and L registers is operated upon.
+        OP(0x04, "INR", 1, OPERAND_DST_REGISTER, 5),
+        // Format: DCR reg
+        // reg can be B, C, D, E, H, L, M (memory), or A
+        // Flags affected: Z, S, P, AC
+        // Decrements the specified register or memory location by one.
+        // If a memory reference is specified, then the memory byte addressed by H and L registers is operated upon.
+        OP(0x05, "DCR", 1, OPERAND_DST_REGISTER, 5),
+        // Format: MVI reg,data
+        // reg can be B, C, D, E, H, L, M (memory), or A
+        // data is a 8-bit quantity.
+        // Loads 1 byte immediate data into the register or memory location.
+        // If a memory reference is specified, then the memory byte addressed by H and L registers is operated upon.
+        OP(0x06, "MVI", 2, OPERAND_DST_REGISTER_DATA8, 7),
+        // Rotate the content of the accumulator one bit to the left.
+        // The carry bit is set equal to the high-order bit of the accumulator.
+        OP(0x07, "RLC", 1, OPERAND_NONE, 4),
+        INVALID(0x08, 4),
+        // Format: DAD rp
+        // rp can be B, D, H, or SP
+        // Flags affected: CY
+        // The 16 bit number in the specified register pair is added to the 16 bit number held in the H and L
+        // registers. The result replaces the contents of the H and L registers.
+        OP(0x09, "DAD", 1, OPERAND_PAIR, 10),
+        // Format: LDAX rp
+        // rp can be B or C.
+        // Loads the content of the memory location addressed by the registers B and C or C and D to the
+        // accumulator.
+        OP(0x0A, "LDAX", 1, OPERAND_STAX_PAIR, 7),
+        // Format: DCX rp
+        // rp can be B, D, H, or SP
+        // Decrements the 16 bit data held in the specified register by one.
+        OP(0x0B, "DCX", 1, OPERAND_PAIR, 5),
+        OP(0x0C, "INR", 1, OPERAND_DST_REGISTER, 5),
+        OP(0x0D, "DCR", 1, OPERAND_DST_REGISTER, 5),
+        OP(0x0E, "MVI", 2, OPERAND_DST_REGISTER_DATA8, 7),
+        // Rotate the content of the accumulator one bit to the right.
+        // The carry bit is set equal to the low-order bit of the accumulator.
+        OP(0x0F, "RRC", 1, OPERAND_NONE, 4),
+
+        INVALID(0x10, 4),
+        OP(0x11, "LXI", 3, OPERAND_PAIR_DATA16, 10),
+        OP(0x12, "STAX", 1, OPERAND_STAX_PAIR, 7),
+        OP(0x13, "INX", 1, OPERAND_PAIR, 5),
+        OP(0x14, "INR", 1, OPERAND_DST_REGISTER, 5),
+        OP(0x15, "DCR", 1, OPERAND_DST_REGISTER, 5),
+        OP(0x16, "MVI", 2, OPERAND_DST_REGISTER_DATA8, 7),
+        // Rotate the content of the accumulator one bit to the left, through the carry bit.
+        // The high-order bit of the accumulator replaces the carry bit,
+        // while the carry bit replaces the low-order bit of the accumulator.
+        OP(0x17, "RAL", 1, OPERAND_NONE, 4),
+        INVALID(0x18, 4),
+        OP(0x19, "DAD", 1, OPERAND_PAIR, 10),
+        OP(0x1A, "LDAX", 1, OPERAND_STAX_PAIR, 7),
+        OP(0x1B, "DCX", 1, OPERAND_PAIR, 5),
+        OP(0x1C, "INR", 1, OPERAND_DST_REGISTER, 5),
+        OP(0x1D, "DCR", 1, OPERAND_DST_REGISTER, 5),
+        OP(0x1E, "MVI", 2, OPERAND_DST_REGISTER_DATA8, 7),
+        // Rotate the content of the accumulator one bit to the right, through the carry bit.
+        // The low-order bit of the accumulator replaces the carry bit,
+        // while the carry bit replaces the high-order bit of the accumulator.
+        OP(0x1F, "RAR", 1, OPERAND_NONE, 4),
+
+        INVALID(0x20, 4),
+        OP(0x21, "LXI", 3, OPERAND_PAIR_DATA16, 10),
+        // Format: SHLD addr
+        // addr is a 16-bit value
+        // The content of the L register is stored at the 16-bit memory address.
+        // The content of the H register is stored at the next higher memory address.
+        OP(0x22, "SHLD", 3, OPERAND_ADDRESS, 16),
+        OP(0x23, "INX", 1, OPERAND_PAIR, 5),
+        OP(0x24, "INR", 1, OPERAND_DST_REGISTER, 5),
+        OP(0x25, "DCR", 1, OPERAND_DST_REGISTER, 5),
+        OP(0x26, "MVI", 2, OPERAND_DST_REGISTER_DATA8, 7),
+        // The 8-bit hexadecimal number in the accumulator is converted to two 4-bit binary coded decimal digits.
+        // This is a two step process:
+        // 1. If the least significant 4 bits in the accumulator is greater than 9, or, if the AC (auxiliary carry)
+        //   flag is set, then the accumulator is incremented by six. If a carry out of the least four significant
+        //   bits occurs, then AC is set. Otherwise it is reset.
+        // 2. If the most significant 4 bits in the accumulator is greater than 9, or, if the CY (carry) flag is
+        //   set, then the most significant 4 bits of the accumulator are incremented by six. If a carry out of the
+        //   most significant four bits occurs, then CY is set. Otherwise it is unaffected.
+        //
+        // Flags affected: Z, S, P, CY, AC
+        OP(0x27, "DAA", 1, OPERAND_NONE, 4),
+        INVALID(0x28, 4),
+        OP(0x29, "DAD", 1, OPERAND_PAIR, 10),
+        // Format: LHLD addr
+        // addr is a 16-bit value
+        // The byte at the 16-bit memory address is stored in the L register.
+        // The byte at the next higher memory address is stored in the H register.
+        OP(0x2A, "LHLD", 3, OPERAND_ADDRESS, 16),
+        OP(0x2B, "DCX", 1, OPERAND_PAIR, 5),
+        OP(0x2C, "INR", 1, OPERAND_DST_REGISTER, 5),
+        OP(0x2D, "DCR", 1, OPERAND_DST_REGISTER, 5),
+        OP(0x2E, "MVI", 2, OPERAND_DST_REGISTER_DATA8, 7),
+        // Each bit in the accumulator is complemented
+        OP(0x2F, "CMA", 1, OPERAND_NONE, 4),
+
+        INVALID(0x30, 4),
+        OP(0x31, "LXI", 3, OPERAND_PAIR_DATA16, 10),
+        // Format: STA addr
+        // addr is a 16-bit value
+        // The contents of the accumulator replaces the byte at the specified memory address
+        OP(0x32, "STA", 3, OPERAND_ADDRESS, 13),
+        OP(0x33, "INX", 1, OPERAND_PAIR, 5),
+        OP(0x34, "INR", 1, OPERAND_DST_REGISTER, 10),
+        OP(0x35, "DCR", 1, OPERAND_DST_REGISTER, 10),
+        OP(0x36, "MVI", 2, OPERAND_DST_REGISTER_DATA8, 10),
+        // Set the carry bit to 1
+        OP(0x37, "STC", 1, OPERAND_NONE, 4),
+        INVALID(0x38, 4),
+        OP(0x39, "DAD", 1, OPERAND_PAIR, 10),
+        // Format: LDA addr
+        // addr is a 16-bit value
+        // The byte at the specified memory address replaces the contents of the accumulator
+        OP(0x3A, "LDA", 3, OPERAND_ADDRESS, 13),
+        OP(0x3B, "DCX", 1, OPERAND_PAIR, 5),
+        OP(0x3C, "INR", 1, OPERAND_DST_REGISTER, 5),
+        OP(0x3D, "DCR", 1, OPERAND_DST_REGISTER, 5),
+        OP(0x3E, "MVI", 2, OPERAND_DST_REGISTER_DATA8, 7),
+        // Complement the carry bit
+        OP(0x3F, "CMC", 1, OPERAND_NONE, 4),
+
+        // 0x40-0x7F, except 0x76
+        // Format MOV dst, src
+        // dst or src can be B, C, D, E, H, L, M (memory), or A
+        REGISTER_ROW(0x40, "MOV", OPERAND_MOVE, 5, 7),
+        REGISTER_ROW(0x48, "MOV", OPERAND_MOVE, 5, 7),
+        REGISTER_ROW(0x50, "MOV", OPERAND_MOVE, 5, 7),
+        REGISTER_ROW(0x58, "MOV", OPERAND_MOVE, 5, 7),
+        REGISTER_ROW(0x60, "MOV", OPERAND_MOVE, 5, 7),
+        REGISTER_ROW(0x68, "MOV", OPERAND_MOVE, 5, 7),
+        OP(0x70, "MOV", 1, OPERAND_MOVE, 7),
+        OP(0x71, "MOV", 1, OPERAND_MOVE, 7),
+        OP(0x72, "MOV", 1, OPERAND_MOVE, 7),
+        OP(0x73, "MOV", 1, OPERAND_MOVE, 7),
+        OP(0x74, "MOV", 1, OPERAND_MOVE, 7),
+        OP(0x75, "MOV", 1, OPERAND_MOVE, 7),
+        // The program counter is incremented to the next sequential instruction. The CPU then enters the STOPPED
+        // state and no further activity takes place until an interrupt occurs.
+        OP(0x76, "HLT", 1, OPERAND_NONE, 7),
+        OP(0x77, "MOV", 1, OPERAND_MOVE, 7),
+        REGISTER_ROW(0x78, "MOV", OPERAND_MOVE, 5, 7),
+
+        // Format ADD, reg
+        // reg can be B, C, D, E, H, L, M (memory), or A
+        // Flags affected: CY, S, Z, P, AC
+        // The specified byte is added to the content of the accumulator
+        REGISTER_ROW(0x80, "ADD", OPERAND_REGISTER, 4, 7),
+        // Format ADC, reg
+        // reg can be B, C, D, E, H, L, M (memory), or A
+        // Flags affected: CY, S, Z, P, AC
+        // The specified byte plus the carry bit is added to the content of the accumulator
+        REGISTER_ROW(0x88, "ADC", OPERAND_REGISTER, 4, 7),
+        // Format SUB, reg
+        // reg can be B, C, D, E, H, L, M (memory), or A
+        // Flags affected: CY, S, Z, P, AC
+        // The specified byte is subtracted from the content of the accumulator.
+        // If there is no carry out of the highest order bit, it indicates that a borrow occurred.
+        // In that case the carry bit is set, otherwise it is reset.
+        REGISTER_ROW(0x90, "SUB", OPERAND_REGISTER, 4, 7),
+        // Format SBB, reg
+        // reg can be B, C, D, E, H, L, M (memory), or A
+        // Flags affected: CY, S, Z, P, AC
+        // The specified byte and the carry bit is subtracted from the content of the accumulator.
+        // If there is no carry out of the highest order bit, it indicates that a borrow occurred.
+        // In that case the carry bit is set, otherwise it is reset.
+        REGISTER_ROW(0x98, "SBB", OPERAND_REGISTER, 4, 7),
+        // Format ANA, reg
+        // reg can be B, C, D, E, H, L, M (memory), or A
+        // Flags affected: CY, S, Z, P
+        // The specified byte is ANDed to the content of the accumulator. The carry bit is reset to zero.
+        REGISTER_ROW(0xA0, "ANA", OPERAND_REGISTER, 4, 7),
+        // Format XRA, reg
+        // reg can be B, C, D, E, H, L, M (memory), or A
+        // Flags affected: CY, S, Z, P, AC
+        // The specified byte is XORed to the content of the accumulator. The carry bit is reset to zero.
+        REGISTER_ROW(0xA8, "XRA", OPERAND_REGISTER, 4, 7),
+        // Format ORA, reg
+        // reg can be B, C, D, E, H, L, M (memory), or A
+        // Flags affected: CY, S, Z, P
+        // The specified byte is ORed to the content of the accumulator. The carry bit is reset to zero.
+        REGISTER_ROW(0xB0, "ORA", OPERAND_REGISTER, 4, 7),
+        // Format CMP, reg
+        // reg can be B, C, D, E, H, L, M (memory), or A
+        // Flags affected: CY, S, Z, P
+        // The specified byte is compared to the content of the accumulator. This is done by subtracting the byte
+        // from the accumulator content, but leaving both reg and accumulator unchanged. The condition bits are
+        // set according to the result, in particular, the zero bit set if the contents are equal, otherwise it
+        // is reset.
+        REGISTER_ROW(0xB8, "CMP", OPERAND_REGISTER, 4, 7),
+
+        // Returns if the zero bit is not set
+        OP(0xC0, "RNZ", 1, OPERAND_NONE, 5),
+        // Format: POP rp
+        // reg can be B, D, H, or PSW
+        // Flags affected: CY, S, Z, P only if reg is PSW
+        // The contents of the specified registers are restored from the stack. The content of the first register
+        // is restored from the byte addressed by the stack pointer, and the content of the second register is
+        // restored from the byte at the address one greater than address indicated by the stack pointer.
+        // If PSW is specified, then the state of the five condition bits are restored.
+        // The stack pointer is incremented by two after this operation.
+        OP(0xC1, "POP", 1, OPERAND_STACK_PAIR, 10),
+        // Jump to the specified address if zero bit is unset.
+        OP(0xC2, "JNZ", 3, OPERAND_ADDRESS, 10),
+        // Jump to the specified address.
+        OP(0xC3, "JMP", 3, OPERAND_ADDRESS, 10),
+        // A call operation is performed to the address if the zero bit is unset.
+        OP(0xC4, "CNZ", 3, OPERAND_ADDRESS, 11),
+        // Format: PUSH rp
+        // reg can be B, D, H, or PSW
+        // Flags affected: CY, S, Z, P only if reg is PSW
+        // The contents of the specified registers are stored in the stack. The content of the first register
+        // is stored at the byte addressed by the stack pointer, and the content of the second register is
+        // is stored at the byte at the address one greater than address indicated by the stack pointer.
+        // If PSW is specified, then the state of the five condition bits is stored.
+        // The stack pointer is decremented by two after this operation.
+        OP(0xC5, "PUSH", 1, OPERAND_STACK_PAIR, 11),
+        // Format: ADI data
+        // data is a 8 byte value
+        // Flags affected: CY, Z, S, P, AC
+        // The byte of immediate data is added to the accumulator.
+        OP(0xC6, "ADI", 2, OPERAND_DATA8, 7),
+        // Format: RST exp
+        // exp is a 3-bit value.
+        // The content of the program counter is pushed onto the stack, so that a subsequent RETURN instruction can
+        // return to that address. Program execution continues at the memory address 0b000000000EXP000B.
+        // Normally this instruction is used for interrupt handling.
+        OP(0xC7, "RST", 1, OPERAND_RST, 11),
+        // Returns if the zero bit set.
+        OP(0xC8, "RZ", 1, OPERAND_NONE, 5),
+        // Returns to the instruction immediately following the last call instruction.
+        OP(0xC9, "RET", 1, OPERAND_NONE, 10),
+        // Jump to the specified address if zero bit is set.
+        OP(0xCA, "JZ", 3, OPERAND_ADDRESS, 10),
+        INVALID(0xCB, 10),
+        // A call operation is performed to the address if the zero bit is set.
+        OP(0xCC, "CZ", 3, OPERAND_ADDRESS, 11),
+        // A call operation is unconditionally performed.
+        OP(0xCD, "CALL", 3, OPERAND_ADDRESS, 17),
+        // Format: ACI data
+        // data is a 8 byte value
+        // Flags affected: CY, Z, S, P, AC
+        // The byte of immediate data is added to the accumulator along with carry bit.
+        OP(0xCE, "ACI", 2, OPERAND_DATA8, 7),
+        OP(0xCF, "RST", 1, OPERAND_RST, 11),
+
+        // Returns if the carry bit is unset.
+        OP(0xD0, "RNC", 1, OPERAND_NONE, 5),
+        OP(0xD1, "POP", 1, OPERAND_STACK_PAIR, 10),
+        // Jump to the specified address if carry bit is not set.
+        OP(0xD2, "JNC", 3, OPERAND_ADDRESS, 10),
+        // Format: OUT exp
+        // exp is a 8-bit value
+        // The contents of the accumulator is sent to the device exp
+        OP(0xD3, "OUT", 2, OPERAND_DATA8, 10),
+        // A call operation is performed if the carry bit is not set.
+        OP(0xD4, "CNC", 3, OPERAND_ADDRESS, 11),
+        OP(0xD5, "PUSH", 1, OPERAND_STACK_PAIR, 11),
+        // Format: SUI data
+        // data is a 8 byte value
+        // Flags affected: CY, Z, S, P, AC
+        // The byte of immediate data is subtracted from the accumulator.
+        OP(0xD6, "SUI", 2, OPERAND_DATA8, 7),
+        OP(0xD7, "RST", 1, OPERAND_RST, 11),
+        // Returns if the carry bit is set.
+        OP(0xD8, "RC", 1, OPERAND_NONE, 5),
+        INVALID(0xD9, 10),
+        // Jump to the specified address if carry bit is set.
+        OP(0xDA, "JC", 3, OPERAND_ADDRESS, 10),
+        // Format: IN exp
+        // exp is a 8-bit value
+        // A byte of data is read from the device number exp and it replaces the contents of the accumulator
+        OP(0xDB, "IN", 2, OPERAND_DATA8, 10),
+        // A call operation is performed to the carry bit is set.
+        OP(0xDC, "CC", 3, OPERAND_ADDRESS, 11),
+        INVALID(0xDD, 17),
+        // Format: SBI data
+        // data is a 8 byte value
+        // Flags affected: CY, Z, S, P, AC
+        // The byte of immediate data is subtracted from the accumulator along with the carry bit.
+        OP(0xDE, "SBI", 2, OPERAND_DATA8, 7),
+        OP(0xDF, "RST", 1, OPERAND_RST, 11),
+
+        // Returns if the parity bit is zero (odd parity).
+        OP(0xE0, "RPO", 1, OPERAND_NONE, 5),
+        OP(0xE1, "POP", 1, OPERAND_STACK_PAIR, 10),
+        // Jump to the specified address if the parity bit is zero.
+        OP(0xE2, "JPO", 3, OPERAND_ADDRESS, 10),
+        // The content of the L register is exchanged with the content of the memory byte addressed by the stack
+        // pointer. The content of the H register is exchanged with the address that's one greater than the address
+        // referenced by the stack pointer.
+        OP(0xE3, "XTHL", 1, OPERAND_NONE, 18),
+        // A call operation is performed to the parity bit is zero.
+        OP(0xE4, "CPO", 3, OPERAND_ADDRESS, 11),
+        OP(0xE5, "PUSH", 1, OPERAND_STACK_PAIR, 11),
+        // Format: ANI data
+        // data is a 8 byte value
+        // Flags affected: CY, Z, S, P, AC
+        // The byte of immediate data is ANDed with the accumulator.
+        OP(0xE6, "ANI", 2, OPERAND_DATA8, 7),
+        OP(0xE7, "RST", 1, OPERAND_RST, 11),
+        // Returns if the parity bit is set (even parity).
+        OP(0xE8, "RPE", 1, OPERAND_NONE, 5),
+        // The content of the H register replaces the most significant 8 bits of the program counter.
+        // The content of the L register replaces the least significant 8 bits of the program counter.
+        OP(0xE9, "PCHL", 1, OPERAND_NONE, 5),
+        // Jump to the specified address if the parity bit is set.
+        OP(0xEA, "JPE", 3, OPERAND_ADDRESS, 10),
+        // The 16 bits of data held in H and L register are exchanged with the 16 bits of data in D and E registers.
+        OP(0xEB, "XCHG", 1, OPERAND_NONE, 4),
+        // A call operation is performed to the address if the parity bit is set.
+        OP(0xEC, "CPE", 3, OPERAND_ADDRESS, 11),
+        INVALID(0xED, 17),
+        // Format: XRI data
+        // data is a 8 byte value
+        // Flags affected: CY, Z, S, P, AC
+        // The byte of immediate data is XORed with the accumulator.
+        OP(0xEE, "XRI", 2, OPERAND_DATA8, 7),
+        OP(0xEF, "RST", 1, OPERAND_RST, 11),
+
+        // Returns if the sign bit is zero (indicating a positive result).
+        OP(0xF0, "RP", 1, OPERAND_NONE, 5),
+        OP(0xF1, "POP", 1, OPERAND_STACK_PAIR, 10),
+        // Jump to the specified address if the sign bit is zero.
+        OP(0xF2, "JP", 3, OPERAND_ADDRESS, 10),
+        // Disable the interrupt system.
+        OP(0xF3, "DI", 1, OPERAND_NONE, 4),
+        // A call operation is performed to the sign bit is zero.
+        OP(0xF4, "CP", 3, OPERAND_ADDRESS, 11),
+        OP(0xF5, "PUSH", 1, OPERAND_STACK_PAIR, 11),
+        // Format: ORI data
+        // data is a 8 byte value
+        // Flags affected: CY, Z, S, P, AC
+        // The byte of immediate data is ORed with the accumulator.
+        OP(0xF6, "ORI", 2, OPERAND_DATA8, 7),
+        OP(0xF7, "RST", 1, OPERAND_RST, 11),
+        // Returns if the sign bit is one (indicating a minus result).
+        OP(0xF8, "RM", 1, OPERAND_NONE, 5),
+        // Loads the content of the H and L registers into the stack pointer.
+        OP(0xF9, "SPHL", 1, OPERAND_NONE, 5),
+        // Jump to the specified address the sign bit is one.
+        OP(0xFA, "JM", 3, OPERAND_ADDRESS, 10),
+        // Enable the interrupt system.
+        OP(0xFB, "EI", 1, OPERAND_NONE, 4),
+        // A call operation is performed to the address if the sign bit is one.
+        OP(0xFC, "CM", 3, OPERAND_ADDRESS, 11),
+        INVALID(0xFD, 17),
+        // Format: CPI data
+        // data is a 8 byte value
+        // Flags affected: CY, Z, S, P, AC
+        // The byte of immediate data is compared with the accumulator.
+        OP(0xFE, "CPI", 2, OPERAND_DATA8, 7),
+        OP(0xFF, "RST", 1, OPERAND_RST, 11),
+};
+
+int decodeInstruction(const uint8_t *code, size_t size, size_t pc, Instruction *instruction) {
+    uint8_t opCode = code[pc];
+    const OpcodeInfo *info = &opcodeTable[opCode];
+    if (size - pc < info->length) {
+        return 0;
+    }
+
+    instruction->opCode = opCode;
+    instruction->info = info;
+    switch (info->length) {
+        case 2:
+            instruction->operand = code[pc + 1];
+            break;
+        case 3:
+            instruction->operand = code[pc + 1] | (code[pc + 2] << 8);
+            break;
+        default:
+            instruction->operand = 0;
+    }
+    return info->length;
+}
+
+// The documented instruction an undocumented opcode executes as
+static uint8_t canonicalOpcode(uint8_t opCode) {
+    switch (opCode) {
+        case 0x08:
+        case 0x10:
+        case 0x18:
+        case 0x20:
+        case 0x28:
+        case 0x30:
+        case 0x38:
+            return 0x00;
+        case 0xCB:
+            return 0xC3;
+        case 0xD9:
+            return 0xC9;
+        case 0xDD:
+        case 0xED:
+        case 0xFD:
+            return 0xCD;
+        default:
+            return opCode;
+    }
+}
+
+int decodeCanonical(const uint8_t *code, size_t size, size_t pc, Instruction *instruction) {
+    uint8_t canonical[3] = {canonicalOpcode(code[pc]), 0, 0};
+    size_t length = size - pc < sizeof(canonical) ? size - pc : sizeof(canonical);
+    memcpy(canonical + 1, code + pc + 1, length - 1);
+    return decodeInstruction(canonical, length, 0, instruction);
+}
+
+static const char *const registerNames[8] = {"B", "C", "D", "E", "H", "L", "M", "A"};
+static const char *const registerPairNames[4] = {"B", "D", "H", "SP"};
+static const char *const stackPairNames[4] = {"B", "D", "H", "PSW"};
+
+const char *registerName(int threeBits) {
+    return registerNames[threeBits & 0x7];
+}
+
+const char *registerPairName(int opCode) {
+    return registerPairNames[OPCODE_PAIR(opCode)];
+}
+
+const char *stackPairName(int opCode) {
+    return stackPairNames[OPCODE_PAIR(opCode)];
+}
+
+const char *staxPairName(int opCode) {
+    return (opCode & 0x10) ? "D" : "B";
+}
+
+#pragma clang diagnostic pop
@@ -0,0 +1,90 @@
+#ifndef OPCODES_H
+#define OPCODES_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+// Register fields encoded in an opcode byte
+#define OPCODE_DST(opCode) (((opCode) >> 3) & 0x7)
+#define OPCODE_SRC(opCode) ((opCode) & 0x7)
+#define OPCODE_PAIR(opCode) (((opCode) >> 4) & 0x3)
+
+#define CONDITION_MET_CYCLES 6
+
+typedef enum {
+    OPERAND_INVALID,            // Not a documented 8080 instruction
+    OPERAND_NONE,               // NOP
+    OPERAND_REGISTER,           // ADD reg, reg in bits 0-2
+    OPERAND_DST_REGISTER,       // INR reg, reg in bits 3-5
+    OPERAND_DST_REGISTER_DATA8, // MVI reg,data
+    OPERAND_MOVE,               // MOV dst,src
+    OPERAND_PAIR,               // INX rp, rp can be B, D, H, or SP
+    OPERAND_PAIR_DATA16,        // LXI rp,data
+    OPERAND_STACK_PAIR,         // PUSH rp, rp can be B, D, H, or PSW
+    OPERAND_STAX_PAIR,          // STAX rp, rp can be B or D
+    OPERAND_DATA8,              // ADI data, OUT exp
+    OPERAND_ADDRESS,            // JMP addr
+    OPERAND_RST                 // RST exp, exp in bits 3-5
+} OperandKind;
+
+// How an instruction changes the flow of control. The undocumented aliases of JMP, CALL and RET are classified
+// like the instruction they execute as.
+typedef enum {
+    FLOW_NONE,
+    FLOW_JUMP,                // JMP
+    FLOW_CONDITIONAL_JUMP,    // Jcc
+    FLOW_CALL,                // CALL
+    FLOW_CONDITIONAL_CALL,    // Ccc
+    FLOW_RETURN,              // RET
+    FLOW_CONDITIONAL_RETURN,  // Rcc
+    FLOW_RESTART,             // RST
+    FLOW_INDIRECT_JUMP,       // PCHL
+    FLOW_HALT                 // HLT
+} ControlFlow;
+
+typedef struct {
+    const char *mnemonic;
+    uint8_t length;
+    uint8_t operandKind;
+    uint8_t dst;
+    uint8_t src;
+    uint8_t registerPair;
+    // Duration in clock cycles. Conditional calls and returns take CONDITION_MET_CYCLES more when they are taken.
+    uint8_t cycles;
+    uint8_t flow;
+} OpcodeInfo;
+
+typedef struct {
+    uint8_t opCode;
+    const OpcodeInfo *info;
+    // 8-bit data or port number, or the 16-bit data or address assembled from its two little endian bytes
+    uint16_t operand;
+} Instruction;
+
+// Descriptor for every opcode, indexed by the opcode byte
+extern const OpcodeInfo opcodeTable[256];
+
+// Decodes the instruction at pc. Returns its length, or 0 if the instruction is cut off by the end of the code.
+int decodeInstruction(const uint8_t *code, size_t size, size_t pc, Instruction *instruction);
+
+// Decodes the instruction at pc as the documented instruction the 8080 executes it as, for code that runs rather than
+// a listing: the undocumented NOPs as NOP and the aliases of JMP, CALL and RET as those, with their length and
+// operand. The opcode of the instruction is the documented one. Returns its length, or 0 if it is cut off.
+int decodeCanonical(const uint8_t *code, size_t size, size_t pc, Instruction *instruction);
+
+// Names of the registers and register pairs in the syntax of the 8080 assembler. Only the bits that encode them
+// are looked at, so any argument yields a name.
+
+// B, C, D, E, H, L, M or A for bits 0-2 of threeBits
+const char *registerName(int threeBits);
+
+// B, D, H or SP for bits 4-5 of the opcode of LXI, INX, DCX and DAD
+const char *registerPairName(int opCode);
+
+// B, D, H or PSW for bits 4-5 of the opcode of PUSH and POP
+const char *stackPairName(int opCode);
+
+// B or D for bit 4 of the opcode of STAX and LDAX
+const char *staxPairName(int opCode);
+
+#endif
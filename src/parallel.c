@@ -0,0 +1,317 @@
+#pragma clang diagnostic push
+#pragma ide diagnostic ignored "hicpp-signed-bitwise"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "format.h"
+#include "opcodes.h"
+#include "parallel.h"
+#include "threadpool.h"
+
+// Enough chunks to keep every thread busy when some decode faster than others
+#define CHUNKS_PER_THREAD 4
+#define MIN_CHUNK_SIZE 4096
+
+// A split moves to an entry point at most a quarter of a chunk away
+#define ENTRY_SEARCH_DIVISOR 4
+
+#define RST_VECTOR_COUNT 8
+
+typedef struct {
+    size_t *addresses;
+    size_t count;
+    size_t capacity;
+} AddressList;
+
+// Looks for the targets of JMP, CALL and their conditional forms in one range of the code
+typedef struct {
+    const uint8_t *code;
+    size_t size;
+    size_t start;
+    size_t end;
+    // One bit per address of the code
+    uint8_t *targets;
+} TargetScan;
+
+// Chunks are decoded speculatively from their start, then fixed up in address order once it is known where the
+// sweep actually enters them
+typedef struct {
+    const uint8_t *code;
+    size_t size;
+    size_t start;
+    size_t end;
+    // Address following the last instruction, where the sweep enters the next chunk
+    size_t next;
+    // Set when the instruction at next runs past the end of the code
+    int truncated;
+    int failed;
+    OutputBuffer listing;
+    // Undocumented opcodes in the listing
+    AddressList invalid;
+    // Lines decoded from the actual entry up to the first instruction shared with the speculative listing,
+    // which continues at listingOffset
+    OutputBuffer prefix;
+    size_t listingOffset;
+} Chunk;
+
+static int appendAddress(AddressList *list, size_t address) {
+    if (list->count == list->capacity) {
+        size_t capacity = list->capacity ? list->capacity * 2 : 16;
+        size_t *addresses = realloc(list->addresses, capacity * sizeof(size_t));
+        if (addresses == NULL) {
+            return -1;
+        }
+        list->addresses = addresses;
+        list->capacity = capacity;
+    }
+    list->addresses[list->count++] = address;
+    return 0;
+}
+
+static void scanTargets(void *argument) {
+    TargetScan *scan = argument;
+    for (size_t pc = scan->start; pc < scan->end && pc + 2 < scan->size; pc++) {
+        uint8_t flow = opcodeTable[scan->code[pc]].flow;
+        if (flow == FLOW_JUMP || flow == FLOW_CONDITIONAL_JUMP || flow == FLOW_CALL || flow == FLOW_CONDITIONAL_CALL) {
+            size_t target = scan->code[pc + 1] | (scan->code[pc + 2] << 8);
+            if (target < scan->size) {
+                scan->targets[target >> 3] |= 1 << (target & 0x7);
+            }
+        }
+    }
+}
+
+// Moves offset forward to the first line of the listing at or after pc. Returns 1 if that line is for pc.
+static int seekLine(const OutputBuffer *listing, size_t *offset, size_t pc) {
+    while (*offset < listing->length) {
+        const char *line = listing->data + *offset;
+        size_t address = 0;
+        for (; *line != ' '; line++) {
+            address = address * 16 + (size_t) (*line <= '9' ? *line - '0' : *line - 'A' + 10);
+        }
+        if (address >= pc) {
+            return address == pc;
+        }
+        const char *newLine = memchr(line, '\n', (size_t) (listing->data + listing->length - line));
+        *offset = (size_t) (newLine + 1 - listing->data);
+    }
+    return 0;
+}
+
+// Decodes from pc up to the end of the chunk and leaves the address it stopped at in next. When resyncOffset is
+// given, stops at the first instruction the speculative listing also holds and returns 1. Returns 0 when the end
+// was reached, -1 on failure.
+static int sweep(Chunk *chunk, size_t pc, OutputBuffer *listing, AddressList *invalid, size_t *resyncOffset) {
+    Instruction instruction;
+    int status = 0;
+    while (pc < chunk->end) {
+        if (resyncOffset != NULL && seekLine(&chunk->listing, resyncOffset, pc)) {
+            status = 1;
+            break;
+        }
+
+        int length = decodeInstruction(chunk->code, chunk->size, pc, &instruction);
+        if (length == 0) {
+            chunk->truncated = 1;
+            break;
+        }
+        if (instruction.info->operandKind == OPERAND_INVALID && appendAddress(invalid, pc) != 0) {
+            return -1;
+        }
+        if (formatInstruction(listing, pc, &instruction) != 0) {
+            return -1;
+        }
+        pc += length;
+    }
+    chunk->next = pc;
+    return status;
+}
+
+static void decodeChunk(void *argument) {
+    Chunk *chunk = argument;
+    if (initOutputBuffer(&chunk->listing, -1) != 0 ||
+        sweep(chunk, chunk->start, &chunk->listing, &chunk->invalid, NULL) != 0) {
+        chunk->failed = 1;
+    }
+}
+
+// Decodes the chunk again from where the sweep actually enters it, until it falls in step with the speculative
+// listing. Returns 0 on success, -1 on failure.
+static int fixChunk(Chunk *chunk, size_t entry) {
+    size_t speculativeNext = chunk->next;
+    int speculativeTruncated = chunk->truncated;
+    AddressList invalid = {NULL, 0, 0};
+    size_t offset = 0;
+    chunk->truncated = 0;
+    int resynced = -1;
+    if (initOutputBuffer(&chunk->prefix, -1) == 0) {
+        resynced = sweep(chunk, entry, &chunk->prefix, &invalid, &offset);
+    }
+
+    if (resynced == 1) {
+        // From here on the speculative listing is right, including where it ends
+        size_t resyncAddress = chunk->next;
+        for (size_t i = 0; i < chunk->invalid.count && resynced >= 0; i++) {
+            size_t address = chunk->invalid.addresses[i];
+            if (address >= resyncAddress && appendAddress(&invalid, address) != 0) {
+                resynced = -1;
+            }
+        }
+        chunk->next = speculativeNext;
+        chunk->truncated = speculativeTruncated;
+        chunk->listingOffset = offset;
+    } else {
+        chunk->listingOffset = chunk->listing.length;
+    }
+
+    free(chunk->invalid.addresses);
+    chunk->invalid = invalid;
+    return resynced < 0 ? -1 : 0;
+}
+
+// Splits the code into chunks of about the same size, moving every split to the nearest entry point within
+// reach, where the sweep is likely to be in step with a decode starting there. Returns the number of chunks.
+static size_t splitChunks(Chunk *chunks, size_t chunkCount, const uint8_t *code, size_t size, const uint8_t *entries) {
+    size_t count = 0;
+    size_t reach = size / chunkCount / ENTRY_SEARCH_DIVISOR;
+    chunks[count++].start = 0;
+    for (size_t i = 1; i < chunkCount; i++) {
+        size_t split = size / chunkCount * i;
+        for (size_t distance = 0; distance <= reach; distance++) {
+            if (split + distance < size && (entries[(split + distance) >> 3] & (1 << ((split + distance) & 0x7)))) {
+                split += distance;
+                break;
+            }
+            if (distance <= split && (entries[(split - distance) >> 3] & (1 << ((split - distance) & 0x7)))) {
+                split -= distance;
+                break;
+            }
+        }
+        if (split > chunks[count - 1].start) {
+            chunks[count++].start = split;
+        }
+    }
+
+    for (size_t i = 0; i < count; i++) {
+        chunks[i].code = code;
+        chunks[i].size = size;
+        chunks[i].end = i + 1 < count ? chunks[i + 1].start : size;
+    }
+    return count;
+}
+
+static void freeChunks(Chunk *chunks, size_t count) {
+    for (size_t i = 0; i < count; i++) {
+        free(chunks[i].listing.data);
+        free(chunks[i].prefix.data);
+        free(chunks[i].invalid.addresses);
+    }
+    free(chunks);
+}
+
+// Marks the RST vectors and the targets of every byte sequence that looks like a jump or call. Returns a bitmap of
+// the entry points, NULL on failure.
+static uint8_t *findEntries(ThreadPool *pool, const uint8_t *code, size_t size) {
+    size_t scanCount = (size_t) pool->threadCount;
+    size_t bitmapSize = (size + 7) / 8;
+    TargetScan *scans = calloc(scanCount, sizeof(TargetScan));
+    uint8_t *entries = calloc(bitmapSize, 1);
+    int failed = scans == NULL || entries == NULL;
+    for (size_t i = 0; i < scanCount && !failed; i++) {
+        scans[i].code = code;
+        scans[i].size = size;
+        scans[i].start = size / scanCount * i;
+        scans[i].end = i + 1 < scanCount ? size / scanCount * (i + 1) : size;
+        scans[i].targets = calloc(bitmapSize, 1);
+        failed = scans[i].targets == NULL || threadPoolSubmit(pool, scanTargets, &scans[i]) != 0;
+    }
+    threadPoolWait(pool);
+
+    for (size_t i = 0; i < scanCount && scans != NULL; i++) {
+        for (size_t byte = 0; byte < bitmapSize && !failed; byte++) {
+            entries[byte] |= scans[i].targets[byte];
+        }
+        free(scans[i].targets);
+    }
+    free(scans);
+    if (failed) {
+        fprintf(stderr, "Cannot allocate the entry point bitmap\n");
+        free(entries);
+        return NULL;
+    }
+
+    for (size_t vector = 0; vector < RST_VECTOR_COUNT * 8 && vector < size; vector += 8) {
+        entries[vector >> 3] |= 1 << (vector & 0x7);
+    }
+    return entries;
+}
+
+int disassembleParallel(const uint8_t *code, size_t size, int threadCount, int fd) {
+    if (size == 0) {
+        return 0;
+    }
+    size_t chunkCount = (size_t) threadCount * CHUNKS_PER_THREAD;
+    if (chunkCount > size / MIN_CHUNK_SIZE) {
+        chunkCount = size / MIN_CHUNK_SIZE ? size / MIN_CHUNK_SIZE : 1;
+    }
+
+    ThreadPool pool;
+    if (threadPoolInit(&pool, threadCount) != 0) {
+        return -1;
+    }
+    uint8_t *entries = findEntries(&pool, code, size);
+    Chunk *chunks = calloc(chunkCount, sizeof(Chunk));
+    if (entries == NULL || chunks == NULL) {
+        free(entries);
+        free(chunks);
+        threadPoolFree(&pool);
+        return -1;
+    }
+    chunkCount = splitChunks(chunks, chunkCount, code, size, entries);
+    free(entries);
+
+    for (size_t i = 0; i < chunkCount; i++) {
+        if (threadPoolSubmit(&pool, decodeChunk, &chunks[i]) != 0) {
+            chunks[i].failed = 1;
+        }
+    }
+    threadPoolWait(&pool);
+    threadPoolFree(&pool);
+
+    // Stitch the listings together in address order, decoding again where a chunk was entered off its start
+    int status = 0;
+    size_t entry = 0;
+    for (size_t i = 0; i < chunkCount; i++) {
+        Chunk *chunk = &chunks[i];
+        if (chunk->failed || (entry != chunk->start && fixChunk(chunk, entry) != 0)) {
+            fprintf(stderr, "Cannot disassemble %04zX-%04zX\n", chunk->start, chunk->end);
+            status = -1;
+            break;
+        }
+        if (entry == chunk->start) {
+            chunk->listingOffset = 0;
+        }
+
+        for (size_t j = 0; j < chunk->invalid.count; j++) {
+            fprintf(stderr, "Invaild opcode %02x\n", code[chunk->invalid.addresses[j]]);
+        }
+        if ((chunk->prefix.data != NULL && writeText(fd, chunk->prefix.data, chunk->prefix.length) != 0) ||
+            writeText(fd, chunk->listing.data + chunk->listingOffset,
+                      chunk->listing.length - chunk->listingOffset) != 0) {
+            status = -1;
+            break;
+        }
+        if (chunk->truncated) {
+            fprintf(stderr, "Truncated instruction at %04X\n", (unsigned int) chunk->next);
+            break;
+        }
+        entry = chunk->next;
+    }
+
+    freeChunks(chunks, chunkCount);
+    return status;
+}
+
+#pragma clang diagnostic pop
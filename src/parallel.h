@@ -0,0 +1,11 @@
+#ifndef PARALLEL_H
+#define PARALLEL_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+// Writes the same listing as a linear sweep from address 0 to fd, decoding chunks of the code on threadCount
+// threads. Returns 0 on success, -1 on failure.
+int disassembleParallel(const uint8_t *code, size_t size, int threadCount, int fd);
+
+#endif
@@ -0,0 +1,161 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "format.h"
+#include "opcodes.h"
+#include "profile.h"
+
+// Column the execution count starts at in the listing
+#define COUNT_COLUMN 24
+
+// Longest annotation or summary line the report adds on top of a listing line
+#define MAX_ANNOTATION_LENGTH 64
+
+#define ADDRESS_COUNT (CPU_PAGE_COUNT << CPU_PAGE_SHIFT)
+
+typedef struct {
+    uint8_t opCode;
+    uint64_t count;
+    uint64_t cycles;
+} OpcodeTotal;
+
+// Most cycles first, ties by opcode
+static int compareTotals(const void *a, const void *b) {
+    const OpcodeTotal *first = a;
+    const OpcodeTotal *second = b;
+    if (first->cycles != second->cycles) {
+        return first->cycles < second->cycles ? 1 : -1;
+    }
+    return first->opCode - second->opCode;
+}
+
+static double percentage(uint64_t cycles, uint64_t totalCycles) {
+    return totalCycles == 0 ? 0.0 : 100.0 * (double) cycles / (double) totalCycles;
+}
+
+// Makes sure a listing line and its annotation fit
+static int reserveLine(OutputBuffer *output) {
+    if (output->capacity - output->length < MAX_LINE_LENGTH + MAX_ANNOTATION_LENGTH) {
+        return flushOutput(output);
+    }
+    return 0;
+}
+
+static int writeSummary(OutputBuffer *output, const Profile *profile, uint64_t totalCycles) {
+    OpcodeTotal totals[256];
+    int count = 0;
+    for (int opCode = 0; opCode < 256; opCode++) {
+        if (profile->opcodeCounts[opCode] != 0) {
+            totals[count].opCode = (uint8_t) opCode;
+            totals[count].count = profile->opcodeCounts[opCode];
+            totals[count].cycles = profile->opcodeCycles[opCode];
+            count++;
+        }
+    }
+    qsort(totals, (size_t) count, sizeof(OpcodeTotal), compareTotals);
+
+    if (reserveLine(output) != 0) {
+        return -1;
+    }
+    output->length += (size_t) snprintf(output->data + output->length, output->capacity - output->length,
+                                        "; OP INSTRUCTION                COUNT          CYCLES       %%\n");
+    for (int i = 0; i < count; i++) {
+        if (reserveLine(output) != 0) {
+            return -1;
+        }
+        // Formats the opcode like a listing line, then puts the opcode where the address was and drops the data
+        uint8_t code[3] = {totals[i].opCode, 0, 0};
+        Instruction instruction;
+        decodeInstruction(code, sizeof(code), 0, &instruction);
+        size_t lineStart = output->length;
+        if (formatInstruction(output, 0, &instruction) != 0) {
+            return -1;
+        }
+        char *line = output->data + lineStart;
+        snprintf(line, 5, "; %02X", totals[i].opCode);
+        line[4] = ' ';
+        char *data = strpbrk(line, "#$\n");
+        if (data[-1] == ',') {
+            data--;
+        }
+        output->length = (size_t) (data - output->data);
+        while (output->length - lineStart < COUNT_COLUMN) {
+            output->data[output->length++] = ' ';
+        }
+        output->length += (size_t) snprintf(output->data + output->length, output->capacity - output->length,
+                                            " %12llu %15llu %6.2f%%\n", (unsigned long long) totals[i].count,
+                                            (unsigned long long) totals[i].cycles,
+                                            percentage(totals[i].cycles, totalCycles));
+    }
+    return 0;
+}
+
+// Lists the executed instructions in address order, with an empty line wherever unexecuted code was skipped
+static int writeListing(OutputBuffer *output, const Profile *profile, const uint8_t *memory, uint64_t totalCycles) {
+    long expected = -1;
+    for (long pc = 0; pc < ADDRESS_COUNT; pc++) {
+        if (profile->addressCounts[pc] == 0) {
+            continue;
+        }
+        if (reserveLine(output) != 0) {
+            return -1;
+        }
+        if (pc != expected) {
+            output->data[output->length++] = '\n';
+        }
+
+        // Instructions wrap around the end of the address space like the CPU does
+        uint8_t code[3];
+        for (int i = 0; i < 3; i++) {
+            code[i] = memory[(pc + i) % ADDRESS_COUNT];
+        }
+        // Listed as what ran, so an undocumented alias of JMP, CALL or RET shows as that with its operand and length
+        Instruction instruction;
+        int length = decodeCanonical(code, sizeof(code), 0, &instruction);
+        size_t lineStart = output->length;
+        if (formatInstruction(output, (size_t) pc, &instruction) != 0) {
+            return -1;
+        }
+
+        output->length--;
+        while (output->length - lineStart < COUNT_COLUMN) {
+            output->data[output->length++] = ' ';
+        }
+        output->length += (size_t) snprintf(output->data + output->length, output->capacity - output->length,
+                                            " ; %12llu %6.2f%%\n",
+                                            (unsigned long long) profile->addressCounts[pc],
+                                            percentage(profile->addressCycles[pc], totalCycles));
+        expected = pc + length;
+    }
+    return 0;
+}
+
+void profileReset(Profile *profile) {
+    memset(profile, 0, sizeof(*profile));
+}
+
+int profileWriteReport(const Profile *profile, const uint8_t *memory, int fd) {
+    uint64_t totalCycles = 0;
+    uint64_t totalCount = 0;
+    for (int opCode = 0; opCode < 256; opCode++) {
+        totalCycles += profile->opcodeCycles[opCode];
+        totalCount += profile->opcodeCounts[opCode];
+    }
+
+    OutputBuffer output;
+    if (initOutputBuffer(&output, fd) != 0) {
+        return -1;
+    }
+    int status = 0;
+    int count = snprintf(output.data, output.capacity, "; %llu instructions, %llu cycles\n",
+                         (unsigned long long) totalCount, (unsigned long long) totalCycles);
+    output.length = (size_t) count;
+    if (writeSummary(&output, profile, totalCycles) != 0 ||
+        writeListing(&output, profile, memory, totalCycles) != 0 ||
+        flushOutput(&output) != 0) {
+        status = -1;
+    }
+    freeOutputBuffer(&output);
+    return status;
+}
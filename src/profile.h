@@ -0,0 +1,25 @@
+#ifndef PROFILE_H
+#define PROFILE_H
+
+#include <stdint.h>
+
+#include "cpu.h"
+
+// Counts executions and cycles by opcode and by the address an instruction started at. The interpreters only fill
+// in a Profile when every file is compiled with CPU_PROFILE defined, see cpu.h.
+struct Profile {
+    uint64_t opcodeCounts[256];
+    uint64_t opcodeCycles[256];
+    uint64_t addressCounts[CPU_PAGE_COUNT << CPU_PAGE_SHIFT];
+    uint64_t addressCycles[CPU_PAGE_COUNT << CPU_PAGE_SHIFT];
+};
+
+typedef struct Profile Profile;
+
+void profileReset(Profile *profile);
+
+// Writes a summary of the opcodes by the cycles they took, followed by the listing of every executed instruction,
+// decoded from memory, with its execution count and share of the cycles. Returns 0 on success, -1 on failure.
+int profileWriteReport(const Profile *profile, const uint8_t *memory, int fd);
+
+#endif
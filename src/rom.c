@@ -0,0 +1,164 @@
+#include <errno.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "rom.h"
+
+// Reads until size bytes are read or the end of the file is reached
+static long readFully(int fd, uint8_t *buffer, size_t size) {
+    size_t total = 0;
+    while (total < size) {
+        ssize_t count = read(fd, buffer + total, size - total);
+        if (count < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            return -1;
+        }
+        if (count == 0) {
+            break;
+        }
+        total += (size_t) count;
+    }
+    return (long) total;
+}
+
+int openRomImage(const char *fileName, RomImage *image) {
+    int fd = open(fileName, O_RDONLY);
+    if (fd < 0) {
+        fprintf(stderr, "Cannot open %s: %s\n", fileName, strerror(errno));
+        return -1;
+    }
+
+    struct stat status;
+    if (fstat(fd, &status) != 0) {
+        fprintf(stderr, "Cannot stat %s: %s\n", fileName, strerror(errno));
+        close(fd);
+        return -1;
+    }
+
+    image->data = NULL;
+    image->size = (size_t) status.st_size;
+    image->mapped = 0;
+    if (image->size == 0) {
+        close(fd);
+        return 0;
+    }
+
+    void *mapping = mmap(NULL, image->size, PROT_READ, MAP_PRIVATE, fd, 0);
+    if (mapping != MAP_FAILED) {
+        image->data = mapping;
+        image->mapped = 1;
+        close(fd);
+        return 0;
+    }
+
+    uint8_t *buffer = malloc(image->size);
+    if (buffer == NULL || readFully(fd, buffer, image->size) != (long) image->size) {
+        fprintf(stderr, "Cannot read %s\n", fileName);
+        free(buffer);
+        close(fd);
+        return -1;
+    }
+    image->data = buffer;
+    close(fd);
+    return 0;
+}
+
+void closeRomImage(RomImage *image) {
+    if (image->mapped) {
+        munmap((void *) image->data, image->size);
+    } else {
+        free((void *) image->data);
+    }
+    image->data = NULL;
+    image->size = 0;
+}
+
+long loadRom(const char *fileName, uint8_t *memory, uint16_t address) {
+    int fd = open(fileName, O_RDONLY);
+    if (fd < 0) {
+        fprintf(stderr, "Cannot open %s: %s\n", fileName, strerror(errno));
+        return -1;
+    }
+
+    struct stat status;
+    if (fstat(fd, &status) == 0 && S_ISREG(status.st_mode) && status.st_size > MEMORY_SIZE - address) {
+        fprintf(stderr, "%s does not fit in memory at %04X\n", fileName, address);
+        close(fd);
+        return -1;
+    }
+
+    long size = readFully(fd, memory + address, MEMORY_SIZE - address);
+    if (size < 0) {
+        fprintf(stderr, "Cannot read %s: %s\n", fileName, strerror(errno));
+    }
+    close(fd);
+    return size;
+}
+
+long loadRomSet(const char *manifestName, uint8_t *memory) {
+    FILE *manifest = fopen(manifestName, "r");
+    if (manifest == NULL) {
+        fprintf(stderr, "Cannot open %s: %s\n", manifestName, strerror(errno));
+        return -1;
+    }
+
+    const char *separator = strrchr(manifestName, '/');
+    int directoryLength = separator == NULL ? 0 : (int) (separator - manifestName + 1);
+
+    long end = 0;
+    char line[512];
+    for (int lineNumber = 1; fgets(line, sizeof(line), manifest) != NULL; lineNumber++) {
+        char fileName[256];
+        unsigned int address, checksum;
+        int fields = sscanf(line, "%255s %x %x", fileName, &address, &checksum);
+        if (fields <= 0 || fileName[0] == '#') {
+            continue;
+        }
+        if (fields < 2 || address >= MEMORY_SIZE) {
+            fprintf(stderr, "%s:%d: expected a file name and a load address\n", manifestName, lineNumber);
+            end = -1;
+            break;
+        }
+
+        char path[sizeof(line) + sizeof(fileName)];
+        snprintf(path, sizeof(path), "%.*s%s", directoryLength, manifestName, fileName);
+        long size = loadRom(path, memory, (uint16_t) address);
+        if (size < 0) {
+            end = -1;
+            break;
+        }
+        if (fields == 3 && crc32(memory + address, (size_t) size) != checksum) {
+            fprintf(stderr, "%s: checksum mismatch, expected %08X\n", path, checksum);
+            end = -1;
+            break;
+        }
+        if ((long) address + size > end) {
+            end = (long) address + size;
+        }
+    }
+
+    fclose(manifest);
+    return end;
+}
+
+uint32_t crc32(const uint8_t *data, size_t size) {
+    return crc32Update(0, data, size);
+}
+
+uint32_t crc32Update(uint32_t crc, const uint8_t *data, size_t size) {
+    crc = ~crc;
+    for (size_t i = 0; i < size; i++) {
+        crc ^= data[i];
+        for (int bit = 0; bit < 8; bit++) {
+            crc = (crc >> 1) ^ (0xEDB88320 & -(crc & 1));
+        }
+    }
+    return ~crc;
+}
@@ -0,0 +1,37 @@
+#ifndef ROM_H
+#define ROM_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+// Size of the 8080 address space
+#define MEMORY_SIZE 0x10000
+
+typedef struct {
+    const uint8_t *data;
+    size_t size;
+    int mapped;
+} RomImage;
+
+// Maps the whole file read-only, falls back to reading it in one call when it can't be mapped.
+// Returns 0 on success, -1 on failure.
+int openRomImage(const char *fileName, RomImage *image);
+
+void closeRomImage(RomImage *image);
+
+// Reads the file in one call into the 64 KiB address space starting at address.
+// Returns the number of bytes loaded, -1 on failure.
+long loadRom(const char *fileName, uint8_t *memory, uint16_t address);
+
+// Loads every file of a ROM set into memory in one pass over its manifest. Each manifest line holds a file name
+// relative to the manifest, its hexadecimal load address and optionally the CRC-32 the file must match.
+// Lines starting with # are comments. Returns the end address of the highest loaded file, -1 on failure.
+long loadRomSet(const char *manifestName, uint8_t *memory);
+
+uint32_t crc32(const uint8_t *data, size_t size);
+
+// Continues the CRC-32 of earlier data with more of it, crc32Update(crc32(a), b) is the CRC-32 of a followed by b.
+// Starts with a crc of 0.
+uint32_t crc32Update(uint32_t crc, const uint8_t *data, size_t size);
+
+#endif
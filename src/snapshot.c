@@ -0,0 +1,404 @@
+#pragma clang diagnostic push
+#pragma ide diagnostic ignored "hicpp-signed-bitwise"
+
+#include <errno.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "rom.h"
+#include "snapshot.h"
+
+#define SNAPSHOT_DELTA 1
+
+// Magic, version, options, CRC-32 of the base memory and page count
+#define HEADER_SIZE 22
+// Registers, flags, interruptsEnabled, halted, enablePending, sp, pc, cycles and instructions. enablePending was a
+// reserved zero byte before, which still loads the same.
+#define STATE_SIZE 32
+
+static SnapshotPage *newPage(const uint8_t *data) {
+    SnapshotPage *page = malloc(sizeof(SnapshotPage));
+    if (page != NULL) {
+        atomic_init(&page->references, 1);
+        memcpy(page->data, data, SNAPSHOT_PAGE_SIZE);
+    }
+    return page;
+}
+
+static SnapshotPage *retainPage(SnapshotPage *page) {
+    atomic_fetch_add_explicit(&page->references, 1, memory_order_relaxed);
+    return page;
+}
+
+static void releasePage(SnapshotPage *page) {
+    if (page != NULL && atomic_fetch_sub_explicit(&page->references, 1, memory_order_acq_rel) == 1) {
+        free(page);
+    }
+}
+
+static SnapshotPageGroup *newGroup(void) {
+    SnapshotPageGroup *group = calloc(1, sizeof(SnapshotPageGroup));
+    if (group != NULL) {
+        atomic_init(&group->references, 1);
+    }
+    return group;
+}
+
+static SnapshotPageGroup *retainGroup(SnapshotPageGroup *group) {
+    atomic_fetch_add_explicit(&group->references, 1, memory_order_relaxed);
+    return group;
+}
+
+static void releaseGroup(SnapshotPageGroup *group) {
+    if (group == NULL || atomic_fetch_sub_explicit(&group->references, 1, memory_order_acq_rel) != 1) {
+        return;
+    }
+    for (int i = 0; i < SNAPSHOT_GROUP_SIZE; i++) {
+        releasePage(group->pages[i]);
+    }
+    free(group);
+}
+
+static const SnapshotPage *pageOf(const Snapshot *snapshot, int page) {
+    return snapshot->groups[page >> SNAPSHOT_GROUP_SHIFT]->pages[page & (SNAPSHOT_GROUP_SIZE - 1)];
+}
+
+static void watchAllPages(SnapshotTracker *tracker) {
+    for (int page = 0; page < CPU_PAGE_COUNT; page++) {
+        tracker->cpu->watchedPages[page] |= tracker->watcherBit;
+    }
+    memset(tracker->dirty, 0, sizeof(tracker->dirty));
+    tracker->dirtyGroups = 0;
+}
+
+static void markDirty(void *context, uint16_t address) {
+    SnapshotTracker *tracker = context;
+    tracker->dirty[address >> CPU_PAGE_SHIFT] = 1;
+    tracker->dirtyGroups |= 1u << (address >> CPU_PAGE_SHIFT >> SNAPSHOT_GROUP_SHIFT);
+    tracker->cpu->watchedPages[address >> CPU_PAGE_SHIFT] &= ~tracker->watcherBit;
+}
+
+// Watches the dirty pages again, the others are still watched
+static void clearDirtyPages(SnapshotTracker *tracker) {
+    for (int group = 0; group < SNAPSHOT_GROUP_COUNT; group++) {
+        if ((tracker->dirtyGroups & (1u << group)) == 0) {
+            continue;
+        }
+        for (int page = group << SNAPSHOT_GROUP_SHIFT; page < (group + 1) << SNAPSHOT_GROUP_SHIFT; page++) {
+            if (tracker->dirty[page]) {
+                tracker->dirty[page] = 0;
+                tracker->cpu->watchedPages[page] |= tracker->watcherBit;
+            }
+        }
+    }
+    tracker->dirtyGroups = 0;
+}
+
+static void saveState(Snapshot *snapshot, const Cpu *cpu) {
+    memcpy(snapshot->registers, cpu->registers, sizeof(snapshot->registers));
+    snapshot->flags = cpu->flags;
+    snapshot->sp = cpu->sp;
+    snapshot->pc = cpu->pc;
+    snapshot->interruptsEnabled = cpu->interruptsEnabled;
+    snapshot->halted = cpu->halted;
+    snapshot->enablePending = cpu->interruptsEnabled && cpu->instructions == cpu->enableInstruction;
+    snapshot->cycles = cpu->cycles;
+    snapshot->instructions = cpu->instructions;
+}
+
+static void restoreState(Cpu *cpu, const Snapshot *snapshot) {
+    memcpy(cpu->registers, snapshot->registers, sizeof(cpu->registers));
+    cpu->flags = snapshot->flags;
+    cpu->sp = snapshot->sp;
+    cpu->pc = snapshot->pc;
+    cpu->interruptsEnabled = snapshot->interruptsEnabled;
+    cpu->halted = snapshot->halted;
+    cpu->cycles = snapshot->cycles;
+    cpu->instructions = snapshot->instructions;
+    // Any other count leaves the EI in the past
+    cpu->enableInstruction = snapshot->instructions - (snapshot->enablePending ? 0 : 1);
+}
+
+static Snapshot *newSnapshot(void) {
+    Snapshot *snapshot = calloc(1, sizeof(Snapshot));
+    if (snapshot == NULL) {
+        fprintf(stderr, "Cannot allocate a snapshot\n");
+        return NULL;
+    }
+    atomic_init(&snapshot->references, 1);
+    return snapshot;
+}
+
+// Memory matches the snapshot again
+static void setBase(SnapshotTracker *tracker, Snapshot *snapshot) {
+    snapshotRetain(snapshot);
+    snapshotTrackerInvalidate(tracker);
+    tracker->base = snapshot;
+    clearDirtyPages(tracker);
+}
+
+int snapshotTrackerInit(SnapshotTracker *tracker, Cpu *cpu) {
+    memset(tracker, 0, sizeof(*tracker));
+    tracker->cpu = cpu;
+    tracker->watcherBit = cpuAddWriteWatcher(cpu, markDirty, tracker);
+    if (tracker->watcherBit == 0) {
+        fprintf(stderr, "No write watcher left to track snapshots\n");
+        return -1;
+    }
+    watchAllPages(tracker);
+    return 0;
+}
+
+void snapshotTrackerFree(SnapshotTracker *tracker) {
+    cpuRemoveWriteWatcher(tracker->cpu, tracker->watcherBit);
+    snapshotTrackerInvalidate(tracker);
+}
+
+void snapshotTrackerInvalidate(SnapshotTracker *tracker) {
+    snapshotRelease(tracker->base);
+    tracker->base = NULL;
+}
+
+// Copies the group's dirty pages, and all of them without a base
+static SnapshotPageGroup *takeGroup(const SnapshotTracker *tracker, int group) {
+    const SnapshotPageGroup *base = tracker->base != NULL ? tracker->base->groups[group] : NULL;
+    SnapshotPageGroup *copy = newGroup();
+    if (copy == NULL) {
+        return NULL;
+    }
+    for (int i = 0; i < SNAPSHOT_GROUP_SIZE; i++) {
+        int page = (group << SNAPSHOT_GROUP_SHIFT) + i;
+        if (base != NULL && !tracker->dirty[page]) {
+            copy->pages[i] = retainPage(base->pages[i]);
+        } else if ((copy->pages[i] = newPage(tracker->cpu->memory + (page << CPU_PAGE_SHIFT))) == NULL) {
+            releaseGroup(copy);
+            return NULL;
+        }
+    }
+    return copy;
+}
+
+Snapshot *snapshotTake(SnapshotTracker *tracker) {
+    Snapshot *snapshot = newSnapshot();
+    if (snapshot == NULL) {
+        return NULL;
+    }
+    saveState(snapshot, tracker->cpu);
+    for (int group = 0; group < SNAPSHOT_GROUP_COUNT; group++) {
+        if (tracker->base != NULL && (tracker->dirtyGroups & (1u << group)) == 0) {
+            snapshot->groups[group] = retainGroup(tracker->base->groups[group]);
+        } else if ((snapshot->groups[group] = takeGroup(tracker, group)) == NULL) {
+            fprintf(stderr, "Cannot allocate a snapshot page\n");
+            snapshotRelease(snapshot);
+            return NULL;
+        }
+    }
+
+    setBase(tracker, snapshot);
+    return snapshot;
+}
+
+void snapshotRestore(SnapshotTracker *tracker, Snapshot *snapshot) {
+    uint8_t *memory = tracker->cpu->memory;
+    const Snapshot *base = tracker->base;
+    restoreState(tracker->cpu, snapshot);
+    for (int group = 0; group < SNAPSHOT_GROUP_COUNT; group++) {
+        const SnapshotPageGroup *target = snapshot->groups[group];
+        if (base != NULL && (tracker->dirtyGroups & (1u << group)) == 0 && base->groups[group] == target) {
+            continue;
+        }
+        for (int i = 0; i < SNAPSHOT_GROUP_SIZE; i++) {
+            int page = (group << SNAPSHOT_GROUP_SHIFT) + i;
+            if (base == NULL || tracker->dirty[page] || base->groups[group]->pages[i] != target->pages[i]) {
+                memcpy(memory + (page << CPU_PAGE_SHIFT), target->pages[i]->data, SNAPSHOT_PAGE_SIZE);
+                // The other watchers, e.g. a JIT or the video, see the copy like writes by instructions
+                cpuNotifyPageWritten(tracker->cpu, page, tracker->cpu->watchedPages[page] & ~tracker->watcherBit);
+            }
+        }
+    }
+
+    setBase(tracker, snapshot);
+}
+
+Snapshot *snapshotRetain(Snapshot *snapshot) {
+    atomic_fetch_add_explicit(&snapshot->references, 1, memory_order_relaxed);
+    return snapshot;
+}
+
+void snapshotRelease(Snapshot *snapshot) {
+    if (snapshot == NULL || atomic_fetch_sub_explicit(&snapshot->references, 1, memory_order_acq_rel) != 1) {
+        return;
+    }
+    for (int group = 0; group < SNAPSHOT_GROUP_COUNT; group++) {
+        releaseGroup(snapshot->groups[group]);
+    }
+    free(snapshot);
+}
+
+// The CRC-32 of the whole memory, computed page by page
+static uint32_t memoryChecksum(const Snapshot *snapshot) {
+    uint32_t crc = 0;
+    for (int page = 0; page < CPU_PAGE_COUNT; page++) {
+        crc = crc32Update(crc, pageOf(snapshot, page)->data, SNAPSHOT_PAGE_SIZE);
+    }
+    return crc;
+}
+
+static uint8_t *putLittleEndian(uint8_t *out, uint64_t value, int size) {
+    for (int i = 0; i < size; i++) {
+        *out++ = (uint8_t) (value >> (i * 8));
+    }
+    return out;
+}
+
+static uint64_t getLittleEndian(const uint8_t **in, int size) {
+    uint64_t value = 0;
+    for (int i = 0; i < size; i++) {
+        value |= (uint64_t) (*in)[i] << (i * 8);
+    }
+    *in += size;
+    return value;
+}
+
+int snapshotSave(const Snapshot *snapshot, const Snapshot *base, const char *fileName) {
+    int pageCount = 0;
+    for (int page = 0; page < CPU_PAGE_COUNT; page++) {
+        if (base == NULL || pageOf(base, page) != pageOf(snapshot, page)) {
+            pageCount++;
+        }
+    }
+
+    uint8_t header[HEADER_SIZE + STATE_SIZE];
+    uint8_t *out = header;
+    memcpy(out, SNAPSHOT_MAGIC, 8);
+    out = putLittleEndian(out + 8, SNAPSHOT_VERSION, 4);
+    out = putLittleEndian(out, base != NULL ? SNAPSHOT_DELTA : 0, 4);
+    out = putLittleEndian(out, base != NULL ? memoryChecksum(base) : 0, 4);
+    out = putLittleEndian(out, (uint64_t) pageCount, 2);
+    memcpy(out, snapshot->registers, 8);
+    out += 8;
+    *out++ = snapshot->flags;
+    *out++ = snapshot->interruptsEnabled;
+    *out++ = snapshot->halted;
+    *out++ = snapshot->enablePending;
+    out = putLittleEndian(out, snapshot->sp, 2);
+    out = putLittleEndian(out, snapshot->pc, 2);
+    out = putLittleEndian(out, snapshot->cycles, 8);
+    putLittleEndian(out, snapshot->instructions, 8);
+
+    FILE *file = fopen(fileName, "wb");
+    if (file == NULL) {
+        fprintf(stderr, "Cannot create %s: %s\n", fileName, strerror(errno));
+        return -1;
+    }
+    int failed = fwrite(header, sizeof(header), 1, file) != 1;
+    for (int page = 0; page < CPU_PAGE_COUNT && !failed; page++) {
+        if (base == NULL || pageOf(base, page) != pageOf(snapshot, page)) {
+            uint8_t index = (uint8_t) page;
+            failed = fwrite(&index, 1, 1, file) != 1 ||
+                     fwrite(pageOf(snapshot, page)->data, SNAPSHOT_PAGE_SIZE, 1, file) != 1;
+        }
+    }
+    if (fclose(file) != 0 || failed) {
+        fprintf(stderr, "Cannot write %s\n", fileName);
+        return -1;
+    }
+    return 0;
+}
+
+Snapshot *snapshotLoad(const Snapshot *base, const char *fileName) {
+    FILE *file = fopen(fileName, "rb");
+    if (file == NULL) {
+        fprintf(stderr, "Cannot open %s: %s\n", fileName, strerror(errno));
+        return NULL;
+    }
+
+    uint8_t header[HEADER_SIZE + STATE_SIZE];
+    const uint8_t *in = header;
+    if (fread(header, sizeof(header), 1, file) != 1 || memcmp(header, SNAPSHOT_MAGIC, 8) != 0) {
+        fprintf(stderr, "%s is not a snapshot\n", fileName);
+        fclose(file);
+        return NULL;
+    }
+    in += 8;
+    uint32_t version = (uint32_t) getLittleEndian(&in, 4);
+    uint32_t options = (uint32_t) getLittleEndian(&in, 4);
+    uint32_t baseChecksum = (uint32_t) getLittleEndian(&in, 4);
+    int pageCount = (int) getLittleEndian(&in, 2);
+    if (version != SNAPSHOT_VERSION) {
+        fprintf(stderr, "%s is a version %u snapshot, expected version %d\n", fileName, version, SNAPSHOT_VERSION);
+        fclose(file);
+        return NULL;
+    }
+    if ((options & SNAPSHOT_DELTA) != 0 && (base == NULL || memoryChecksum(base) != baseChecksum)) {
+        fprintf(stderr, "%s has to be loaded on top of the snapshot it was saved against\n", fileName);
+        fclose(file);
+        return NULL;
+    }
+    if ((options & SNAPSHOT_DELTA) == 0) {
+        base = NULL;
+    }
+
+    Snapshot *snapshot = newSnapshot();
+    if (snapshot == NULL) {
+        fclose(file);
+        return NULL;
+    }
+    memcpy(snapshot->registers, in, 8);
+    in += 8;
+    snapshot->flags = *in++;
+    snapshot->interruptsEnabled = *in++;
+    snapshot->halted = *in++;
+    snapshot->enablePending = *in++;
+    snapshot->sp = (uint16_t) getLittleEndian(&in, 2);
+    snapshot->pc = (uint16_t) getLittleEndian(&in, 2);
+    snapshot->cycles = getLittleEndian(&in, 8);
+    snapshot->instructions = getLittleEndian(&in, 8);
+
+    int failed = 0;
+    for (int i = 0; i < pageCount && !failed; i++) {
+        uint8_t index;
+        uint8_t data[SNAPSHOT_PAGE_SIZE];
+        failed = fread(&index, 1, 1, file) != 1 || fread(data, SNAPSHOT_PAGE_SIZE, 1, file) != 1;
+        if (failed) {
+            break;
+        }
+        SnapshotPageGroup **group = &snapshot->groups[index >> SNAPSHOT_GROUP_SHIFT];
+        if (*group == NULL && (*group = newGroup()) == NULL) {
+            failed = 1;
+            break;
+        }
+        SnapshotPage **page = &(*group)->pages[index & (SNAPSHOT_GROUP_SIZE - 1)];
+        failed = *page != NULL || (*page = newPage(data)) == NULL;
+    }
+    // Every page missing from the file is the base's
+    for (int group = 0; group < SNAPSHOT_GROUP_COUNT && !failed; group++) {
+        SnapshotPageGroup *loaded = snapshot->groups[group];
+        if (loaded == NULL) {
+            failed = base == NULL;
+            if (!failed) {
+                snapshot->groups[group] = retainGroup(base->groups[group]);
+            }
+            continue;
+        }
+        for (int i = 0; i < SNAPSHOT_GROUP_SIZE && !failed; i++) {
+            if (loaded->pages[i] == NULL) {
+                failed = base == NULL;
+                if (!failed) {
+                    loaded->pages[i] = retainPage(base->groups[group]->pages[i]);
+                }
+            }
+        }
+    }
+    fclose(file);
+
+    if (failed) {
+        fprintf(stderr, "%s is truncated or corrupt\n", fileName);
+        snapshotRelease(snapshot);
+        return NULL;
+    }
+    return snapshot;
+}
+
+#pragma clang diagnostic pop
@@ -0,0 +1,93 @@
+#ifndef SNAPSHOT_H
+#define SNAPSHOT_H
+
+#include <stdatomic.h>
+#include <stdint.h>
+
+#include "cpu.h"
+
+#define SNAPSHOT_MAGIC "8080SNAP"
+#define SNAPSHOT_VERSION 1
+
+#define SNAPSHOT_PAGE_SIZE (1 << CPU_PAGE_SHIFT)
+
+// Pages per group
+#define SNAPSHOT_GROUP_SHIFT 4
+#define SNAPSHOT_GROUP_SIZE (1 << SNAPSHOT_GROUP_SHIFT)
+#define SNAPSHOT_GROUP_COUNT (CPU_PAGE_COUNT / SNAPSHOT_GROUP_SIZE)
+
+// Pages never change once created, snapshots taken from the same machine share the pages it didn't write to
+typedef struct {
+    atomic_int references;
+    uint8_t data[SNAPSHOT_PAGE_SIZE];
+} SnapshotPage;
+
+// Consecutive pages, which never change once created either. A snapshot shares whole groups none of whose pages were
+// written with the last one, so taking it only costs a reference per group and per page of the written groups.
+typedef struct {
+    atomic_int references;
+    SnapshotPage *pages[SNAPSHOT_GROUP_SIZE];
+} SnapshotPageGroup;
+
+// CPU state and memory of a machine at one point in time. Snapshots are immutable and shared by reference
+// counting, so any number of machines can be forked from one.
+typedef struct {
+    atomic_int references;
+    uint8_t registers[8];
+    uint8_t flags;
+    uint16_t sp;
+    uint16_t pc;
+    uint8_t interruptsEnabled;
+    uint8_t halted;
+    // The last instruction was an EI, interrupts are enabled after the next one
+    uint8_t enablePending;
+    uint64_t cycles;
+    uint64_t instructions;
+    SnapshotPageGroup *groups[SNAPSHOT_GROUP_COUNT];
+} Snapshot;
+
+// Follows which pages of a CPU's memory were written since its last snapshot was taken or restored. Only the first
+// write to a page reaches the tracker, it stops watching the page until the next snapshot.
+typedef struct {
+    Cpu *cpu;
+    int watcherBit;
+    // The snapshot memory matched when dirty was cleared, NULL when unknown
+    Snapshot *base;
+    uint8_t dirty[CPU_PAGE_COUNT];
+    // Bit n is set when a page of group n is dirty
+    uint32_t dirtyGroups;
+} SnapshotTracker;
+
+// Returns 0 on success, -1 when the CPU has no write watcher left
+int snapshotTrackerInit(SnapshotTracker *tracker, Cpu *cpu);
+
+void snapshotTrackerFree(SnapshotTracker *tracker);
+
+// Captures the CPU. Only the pages written since the last snapshot are copied, the others are shared with it, and
+// only the groups holding written pages are visited.
+// Memory written other than by executing instructions, e.g. loading a ROM, must be followed by
+// snapshotTrackerInvalidate(). Returns a snapshot holding one reference, NULL on failure.
+Snapshot *snapshotTake(SnapshotTracker *tracker);
+
+// Puts the CPU back in the state of the snapshot, which can come from another CPU. Only pages which were written
+// since the last snapshot, or which differ between the last snapshot and this one, are copied, and the other write
+// watchers of the CPU are called for every address of those pages.
+void snapshotRestore(SnapshotTracker *tracker, Snapshot *snapshot);
+
+// Forgets the last snapshot, so the next one copies every page
+void snapshotTrackerInvalidate(SnapshotTracker *tracker);
+
+Snapshot *snapshotRetain(Snapshot *snapshot);
+
+// Drops a reference, the last one frees the snapshot and the pages no other snapshot shares
+void snapshotRelease(Snapshot *snapshot);
+
+// Writes the snapshot to a file. With a base snapshot, only the pages which differ from it are written and the
+// file can only be loaded on top of the same base. Returns 0 on success, -1 on failure.
+int snapshotSave(const Snapshot *snapshot, const Snapshot *base, const char *fileName);
+
+// Reads a snapshot written by snapshotSave(), with the same base or NULL. Returns a snapshot holding one
+// reference, NULL on failure.
+Snapshot *snapshotLoad(const Snapshot *base, const char *fileName);
+
+#endif
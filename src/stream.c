@@ -0,0 +1,75 @@
+#include <errno.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "format.h"
+#include "opcodes.h"
+#include "stream.h"
+
+// An instruction cut off by the end of a chunk leaves at most its first two bytes to carry into the next one
+#define MAX_CARRIED_BYTES 2
+
+int disassembleStream(int inputFd, int outputFd) {
+    uint8_t *buffer = malloc(MAX_CARRIED_BYTES + STREAM_CHUNK_SIZE);
+    if (buffer == NULL) {
+        fprintf(stderr, "Cannot allocate a stream buffer of %d bytes\n", MAX_CARRIED_BYTES + STREAM_CHUNK_SIZE);
+        return -1;
+    }
+    OutputBuffer output;
+    if (initOutputBuffer(&output, outputFd) != 0) {
+        free(buffer);
+        return -1;
+    }
+
+    int status = 0;
+    // Address of buffer[0], and the bytes of an unfinished instruction at its start
+    size_t address = 0;
+    size_t carried = 0;
+    for (;;) {
+        ssize_t count = read(inputFd, buffer + carried, STREAM_CHUNK_SIZE);
+        if (count < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            perror("read");
+            status = -1;
+            break;
+        }
+        if (count == 0) {
+            if (carried > 0) {
+                fprintf(stderr, "Truncated instruction at %04X\n", (unsigned int) address);
+            }
+            break;
+        }
+
+        size_t size = carried + (size_t) count;
+        size_t pc = 0;
+        Instruction instruction;
+        int length;
+        while (pc < size && (length = decodeInstruction(buffer, size, pc, &instruction)) != 0) {
+            if (instruction.info->operandKind == OPERAND_INVALID) {
+                fprintf(stderr, "Invaild opcode %02x\n", instruction.opCode);
+            }
+            if (formatInstruction(&output, address + pc, &instruction) != 0) {
+                status = -1;
+                break;
+            }
+            pc += length;
+        }
+        if (status != 0) {
+            break;
+        }
+        carried = size - pc;
+        memmove(buffer, buffer + pc, carried);
+        address += pc;
+    }
+
+    if (flushOutput(&output) != 0) {
+        status = -1;
+    }
+    freeOutputBuffer(&output);
+    free(buffer);
+    return status;
+}
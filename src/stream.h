@@ -0,0 +1,11 @@
+#ifndef STREAM_H
+#define STREAM_H
+
+// Bytes read from the input at a time
+#define STREAM_CHUNK_SIZE (256 * 1024)
+
+// Writes the same listing as a linear sweep from address 0 to outputFd, reading the code from inputFd, e.g. a pipe,
+// in chunks. Memory use doesn't depend on the size of the input. Returns 0 on success, -1 on failure.
+int disassembleStream(int inputFd, int outputFd);
+
+#endif
@@ -0,0 +1,109 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "threadpool.h"
+
+static void *work(void *argument) {
+    ThreadPool *pool = argument;
+    pthread_mutex_lock(&pool->lock);
+    for (;;) {
+        while (pool->head == NULL && !pool->shuttingDown) {
+            pthread_cond_wait(&pool->jobQueued, &pool->lock);
+        }
+        if (pool->head == NULL) {
+            break;
+        }
+
+        QueuedJob *queued = pool->head;
+        pool->head = queued->next;
+        if (pool->head == NULL) {
+            pool->tail = NULL;
+        }
+        pthread_mutex_unlock(&pool->lock);
+
+        queued->job(queued->argument);
+        free(queued);
+
+        pthread_mutex_lock(&pool->lock);
+        if (--pool->pending == 0) {
+            pthread_cond_broadcast(&pool->jobsDone);
+        }
+    }
+    pthread_mutex_unlock(&pool->lock);
+    return NULL;
+}
+
+int threadPoolDefaultSize(void) {
+    long processors = sysconf(_SC_NPROCESSORS_ONLN);
+    return processors > 0 ? (int) processors : 1;
+}
+
+int threadPoolInit(ThreadPool *pool, int threadCount) {
+    memset(pool, 0, sizeof(*pool));
+    pool->threads = malloc(sizeof(pthread_t) * threadCount);
+    if (pool->threads == NULL) {
+        fprintf(stderr, "Cannot allocate %d threads\n", threadCount);
+        return -1;
+    }
+    pthread_mutex_init(&pool->lock, NULL);
+    pthread_cond_init(&pool->jobQueued, NULL);
+    pthread_cond_init(&pool->jobsDone, NULL);
+
+    for (; pool->threadCount < threadCount; pool->threadCount++) {
+        int error = pthread_create(&pool->threads[pool->threadCount], NULL, work, pool);
+        if (error != 0) {
+            fprintf(stderr, "Cannot start a worker thread: %s\n", strerror(error));
+            threadPoolFree(pool);
+            return -1;
+        }
+    }
+    return 0;
+}
+
+int threadPoolSubmit(ThreadPool *pool, Job job, void *argument) {
+    QueuedJob *queued = malloc(sizeof(QueuedJob));
+    if (queued == NULL) {
+        fprintf(stderr, "Cannot queue a job\n");
+        return -1;
+    }
+    queued->job = job;
+    queued->argument = argument;
+    queued->next = NULL;
+
+    pthread_mutex_lock(&pool->lock);
+    if (pool->tail != NULL) {
+        pool->tail->next = queued;
+    } else {
+        pool->head = queued;
+    }
+    pool->tail = queued;
+    pool->pending++;
+    pthread_cond_signal(&pool->jobQueued);
+    pthread_mutex_unlock(&pool->lock);
+    return 0;
+}
+
+void threadPoolWait(ThreadPool *pool) {
+    pthread_mutex_lock(&pool->lock);
+    while (pool->pending != 0) {
+        pthread_cond_wait(&pool->jobsDone, &pool->lock);
+    }
+    pthread_mutex_unlock(&pool->lock);
+}
+
+void threadPoolFree(ThreadPool *pool) {
+    pthread_mutex_lock(&pool->lock);
+    pool->shuttingDown = 1;
+    pthread_cond_broadcast(&pool->jobQueued);
+    pthread_mutex_unlock(&pool->lock);
+
+    for (int i = 0; i < pool->threadCount; i++) {
+        pthread_join(pool->threads[i], NULL);
+    }
+    free(pool->threads);
+    pthread_mutex_destroy(&pool->lock);
+    pthread_cond_destroy(&pool->jobQueued);
+    pthread_cond_destroy(&pool->jobsDone);
+}
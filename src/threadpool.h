@@ -0,0 +1,45 @@
+#ifndef THREADPOOL_H
+#define THREADPOOL_H
+
+#include <pthread.h>
+
+typedef void (*Job)(void *argument);
+
+typedef struct QueuedJob {
+    Job job;
+    void *argument;
+    struct QueuedJob *next;
+} QueuedJob;
+
+// Fixed set of worker threads taking jobs from a first in, first out queue
+typedef struct {
+    pthread_t *threads;
+    int threadCount;
+    pthread_mutex_t lock;
+    // Signalled when a job is queued or the pool shuts down
+    pthread_cond_t jobQueued;
+    // Signalled when the last pending job finishes
+    pthread_cond_t jobsDone;
+    QueuedJob *head;
+    QueuedJob *tail;
+    // Jobs queued or running
+    int pending;
+    int shuttingDown;
+} ThreadPool;
+
+// Returns the number of online processors, at least 1
+int threadPoolDefaultSize(void);
+
+// Starts threadCount workers. Returns 0 on success, -1 on failure.
+int threadPoolInit(ThreadPool *pool, int threadCount);
+
+// Queues job(argument) to run on a worker. Returns 0 on success, -1 on failure.
+int threadPoolSubmit(ThreadPool *pool, Job job, void *argument);
+
+// Blocks until every submitted job has finished
+void threadPoolWait(ThreadPool *pool);
+
+// Finishes the queued jobs and joins the workers
+void threadPoolFree(ThreadPool *pool);
+
+#endif
@@ -0,0 +1,120 @@
+#include <errno.h>
+#include <fcntl.h>
+#include <sched.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "format.h"
+#include "trace.h"
+
+// How long the writer sleeps when the ring is empty
+#define WRITER_IDLE_NANOSECONDS 200000
+
+static void *writeRecords(void *argument) {
+    Tracer *tracer = argument;
+    const struct timespec idle = {0, WRITER_IDLE_NANOSECONDS};
+    size_t tail = atomic_load_explicit(&tracer->tail, memory_order_relaxed);
+    for (;;) {
+        // Read stopping before head so the last records added before traceClose() are seen
+        int stopping = atomic_load_explicit(&tracer->stopping, memory_order_acquire);
+        size_t head = atomic_load_explicit(&tracer->head, memory_order_acquire);
+        if (head == tail) {
+            if (stopping) {
+                break;
+            }
+            nanosleep(&idle, NULL);
+            continue;
+        }
+
+        // The records up to head are in at most two contiguous runs of the ring
+        while (tail != head) {
+            size_t index = tail & (tracer->ringSize - 1);
+            size_t count = head - tail;
+            if (count > tracer->ringSize - index) {
+                count = tracer->ringSize - index;
+            }
+            if (!atomic_load_explicit(&tracer->failed, memory_order_relaxed) &&
+                writeText(tracer->fd, (const char *) &tracer->ring[index], count * sizeof(TraceRecord)) != 0) {
+                atomic_store_explicit(&tracer->failed, 1, memory_order_relaxed);
+            }
+            tail += count;
+            atomic_store_explicit(&tracer->tail, tail, memory_order_release);
+        }
+    }
+    return NULL;
+}
+
+int traceOpen(Tracer *tracer, const char *fileName, size_t ringSize) {
+    memset(tracer, 0, sizeof(*tracer));
+    tracer->ringSize = ringSize ? ringSize : TRACE_RING_SIZE;
+    if ((tracer->ringSize & (tracer->ringSize - 1)) != 0) {
+        fprintf(stderr, "The trace ring size %zu is not a power of two\n", tracer->ringSize);
+        return -1;
+    }
+    tracer->fd = open(fileName, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (tracer->fd < 0) {
+        fprintf(stderr, "Cannot create %s: %s\n", fileName, strerror(errno));
+        return -1;
+    }
+
+    TraceHeader header;
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, TRACE_MAGIC, sizeof(header.magic));
+    header.version = TRACE_VERSION;
+    header.recordSize = sizeof(TraceRecord);
+    tracer->ring = malloc(tracer->ringSize * sizeof(TraceRecord));
+    if (tracer->ring == NULL || writeText(tracer->fd, (const char *) &header, sizeof(header)) != 0) {
+        fprintf(stderr, "Cannot start the trace in %s\n", fileName);
+        free(tracer->ring);
+        close(tracer->fd);
+        return -1;
+    }
+
+    int error = pthread_create(&tracer->writer, NULL, writeRecords, tracer);
+    if (error != 0) {
+        fprintf(stderr, "Cannot start the trace writer: %s\n", strerror(error));
+        free(tracer->ring);
+        close(tracer->fd);
+        return -1;
+    }
+    return 0;
+}
+
+int traceClose(Tracer *tracer) {
+    atomic_store_explicit(&tracer->stopping, 1, memory_order_release);
+    pthread_join(tracer->writer, NULL);
+    int failed = atomic_load_explicit(&tracer->failed, memory_order_relaxed);
+    if (close(tracer->fd) != 0) {
+        failed = 1;
+    }
+    free(tracer->ring);
+    tracer->ring = NULL;
+    return failed ? -1 : 0;
+}
+
+void traceInstruction(void *context, const Cpu *cpu) {
+    Tracer *tracer = context;
+    size_t head = atomic_load_explicit(&tracer->head, memory_order_relaxed);
+    if (head - tracer->cachedTail == tracer->ringSize) {
+        tracer->stalls++;
+        while ((tracer->cachedTail = atomic_load_explicit(&tracer->tail, memory_order_acquire)) + tracer->ringSize ==
+               head) {
+            sched_yield();
+        }
+    }
+
+    TraceRecord *record = &tracer->ring[head & (tracer->ringSize - 1)];
+    const uint8_t *memory = cpu->memory;
+    record->cycles = cpu->cycles;
+    record->pc = cpu->pc;
+    record->sp = cpu->sp;
+    record->opCode = memory[cpu->pc];
+    record->operands[0] = memory[(uint16_t) (cpu->pc + 1)];
+    record->operands[1] = memory[(uint16_t) (cpu->pc + 2)];
+    record->flags = cpu->flags;
+    memcpy(record->registers, cpu->registers, sizeof(record->registers));
+    atomic_store_explicit(&tracer->head, head + 1, memory_order_release);
+}
@@ -0,0 +1,65 @@
+#ifndef TRACE_H
+#define TRACE_H
+
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "cpu.h"
+
+#define TRACE_MAGIC "8080TRCE"
+#define TRACE_VERSION 1
+
+// Records the ring buffer holds by default, must be a power of two
+#define TRACE_RING_SIZE (64 * 1024)
+
+// A trace file is a TraceHeader followed by TraceRecords, in host byte order
+typedef struct {
+    char magic[8];
+    uint32_t version;
+    uint32_t recordSize;
+} TraceHeader;
+
+// The state of the CPU right before an instruction executes
+typedef struct {
+    uint64_t cycles;
+    uint16_t pc;
+    uint16_t sp;
+    uint8_t opCode;
+    // The bytes following the opcode, whether the instruction uses them or not
+    uint8_t operands[2];
+    uint8_t flags;
+    // Indexed like Cpu.registers, the slot of M is unused
+    uint8_t registers[8];
+} TraceRecord;
+
+// Records go through a single producer, single consumer ring buffer: the emulation thread adds them with
+// traceInstruction() and a writer thread appends them to the file
+typedef struct {
+    TraceRecord *ring;
+    size_t ringSize;
+    // Count of records ever added and ever written, the ring index is the count modulo ringSize
+    _Atomic size_t head;
+    _Atomic size_t tail;
+    // The producer's last view of tail, so it only reads the shared counter when the ring looks full
+    size_t cachedTail;
+    atomic_int stopping;
+    atomic_int failed;
+    int fd;
+    pthread_t writer;
+    // Times the producer found the ring full and had to wait for the writer
+    uint64_t stalls;
+} Tracer;
+
+// Creates the trace file and starts the writer thread. ringSize of 0 selects TRACE_RING_SIZE.
+// Returns 0 on success, -1 on failure.
+int traceOpen(Tracer *tracer, const char *fileName, size_t ringSize);
+
+// Writes the remaining records and closes the file. Returns 0 if every record was written, -1 otherwise.
+int traceClose(Tracer *tracer);
+
+// TraceHook adding a record of the instruction at pc, pass the Tracer as context
+void traceInstruction(void *context, const Cpu *cpu);
+
+#endif
@@ -0,0 +1,109 @@
+// Replays a binary trace written by the emulator as a listing of the executed instructions, in the same format as
+// the disassembler. With -v every line also shows the registers and the cycle count before the instruction.
+// USAGE: tracedump [-v] FILE
+
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "format.h"
+#include "opcodes.h"
+#include "rom.h"
+#include "trace.h"
+
+// Column the CPU state starts at with -v
+#define STATE_COLUMN 24
+
+// Longest CPU state appendState() adds to a line
+#define MAX_STATE_LENGTH 80
+
+// Replaces the new line ending the listing line which starts at lineStart with the CPU state of the record
+static void appendState(OutputBuffer *output, size_t lineStart, const TraceRecord *record) {
+    output->length--;
+    while (output->length - lineStart < STATE_COLUMN) {
+        output->data[output->length++] = ' ';
+    }
+    int count = snprintf(output->data + output->length, output->capacity - output->length,
+                         " ; A=%02X BC=%02X%02X DE=%02X%02X HL=%02X%02X SP=%04X F=%02X CYC=%llu\n",
+                         record->registers[7], record->registers[0], record->registers[1], record->registers[2],
+                         record->registers[3], record->registers[4], record->registers[5], record->sp, record->flags,
+                         (unsigned long long) record->cycles);
+    output->length += (size_t) count;
+}
+
+int main(int argc, char **argv) {
+    int verbose = 0;
+    int option;
+    while ((option = getopt(argc, argv, "v")) != -1) {
+        switch (option) {
+            case 'v':
+                verbose = 1;
+                break;
+            default:
+                fprintf(stderr, "USAGE: tracedump [-v] FILE\n");
+                return 1;
+        }
+    }
+    if (optind != argc - 1) {
+        fprintf(stderr, "USAGE: tracedump [-v] FILE\n");
+        return 1;
+    }
+
+    RomImage image;
+    if (openRomImage(argv[optind], &image) != 0) {
+        return 1;
+    }
+    TraceHeader header;
+    if (image.size < sizeof(header)) {
+        fprintf(stderr, "%s is not a trace\n", argv[optind]);
+        closeRomImage(&image);
+        return 1;
+    }
+    memcpy(&header, image.data, sizeof(header));
+    if (memcmp(header.magic, TRACE_MAGIC, sizeof(header.magic)) != 0 || header.version != TRACE_VERSION ||
+        header.recordSize != sizeof(TraceRecord)) {
+        fprintf(stderr, "%s is not a version %d trace\n", argv[optind], TRACE_VERSION);
+        closeRomImage(&image);
+        return 1;
+    }
+
+    OutputBuffer output;
+    if (initOutputBuffer(&output, STDOUT_FILENO) != 0) {
+        closeRomImage(&image);
+        return 1;
+    }
+
+    int status = 0;
+    size_t recordCount = (image.size - sizeof(header)) / sizeof(TraceRecord);
+    const uint8_t *records = image.data + sizeof(header);
+    for (size_t i = 0; i < recordCount && status == 0; i++) {
+        TraceRecord record;
+        memcpy(&record, records + i * sizeof(TraceRecord), sizeof(record));
+
+        uint8_t code[3] = {record.opCode, record.operands[0], record.operands[1]};
+        Instruction instruction;
+        decodeInstruction(code, sizeof(code), 0, &instruction);
+        if (output.capacity - output.length < MAX_LINE_LENGTH + MAX_STATE_LENGTH && flushOutput(&output) != 0) {
+            status = 1;
+            break;
+        }
+        size_t lineStart = output.length;
+        if (formatInstruction(&output, record.pc, &instruction) != 0) {
+            status = 1;
+            break;
+        }
+        if (verbose) {
+            appendState(&output, lineStart, &record);
+        }
+    }
+    if ((image.size - sizeof(header)) % sizeof(TraceRecord) != 0) {
+        fprintf(stderr, "The trace ends in a partial record\n");
+    }
+    if (flushOutput(&output) != 0) {
+        status = 1;
+    }
+
+    freeOutputBuffer(&output);
+    closeRomImage(&image);
+    return status;
+}
@@ -0,0 +1,191 @@
+#pragma clang diagnostic push
+#pragma ide diagnostic ignored "hicpp-signed-bitwise"
+
+#include <errno.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "video.h"
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define VIDEO_X86 1
+#include <immintrin.h>
+#else
+#define VIDEO_X86 0
+#endif
+
+#define VIDEO_SIZE (VIDEO_LINES * VIDEO_LINE_BYTES)
+#define ROW_BYTES (VIDEO_WIDTH * sizeof(uint32_t))
+
+// Lines converted together by a kernel, the groups start at a multiple of it
+static const int groupLines[] = {1, 4, 8};
+
+static void markDirty(void *context, uint16_t address) {
+    Video *video = context;
+    video->dirtyLines[(address - VIDEO_ADDRESS) / VIDEO_LINE_BYTES] = 1;
+}
+
+// Pixel x of a line lands in row VIDEO_HEIGHT - 1 - x of the column with the line's number
+static void convertScalar(const uint8_t *vram, uint32_t *pixels, int line) {
+    const uint8_t *bytes = vram + line * VIDEO_LINE_BYTES;
+    uint32_t *column = pixels + (VIDEO_HEIGHT - 1) * VIDEO_WIDTH + line;
+    for (int x = 0; x < VIDEO_HEIGHT; x++) {
+        column[-x * VIDEO_WIDTH] = (bytes[x >> 3] >> (x & 0x7)) & 1 ? VIDEO_WHITE : VIDEO_BLACK;
+    }
+}
+
+#if VIDEO_X86
+
+// Every 32-bit lane holds the byte of one line, its pixel for a bit is all ones or the alpha of black
+__attribute__((target("sse2")))
+static void convertSse2(const uint8_t *vram, uint32_t *pixels, int line) {
+    const uint8_t *bytes = vram + line * VIDEO_LINE_BYTES;
+    const __m128i black = _mm_set1_epi32((int) VIDEO_BLACK);
+    uint8_t *row = (uint8_t *) (pixels + (VIDEO_HEIGHT - 1) * VIDEO_WIDTH + line);
+    for (int byte = 0; byte < VIDEO_LINE_BYTES; byte++) {
+        __m128i lanes = _mm_setr_epi32(bytes[byte], bytes[VIDEO_LINE_BYTES + byte], bytes[2 * VIDEO_LINE_BYTES + byte],
+                                       bytes[3 * VIDEO_LINE_BYTES + byte]);
+        for (int bit = 0; bit < 8; bit++, row -= ROW_BYTES) {
+            __m128i mask = _mm_set1_epi32(1 << bit);
+            __m128i set = _mm_cmpeq_epi32(_mm_and_si128(lanes, mask), mask);
+            _mm_store_si128((__m128i *) row, _mm_or_si128(set, black));
+        }
+    }
+}
+
+__attribute__((target("avx2")))
+static void convertAvx2(const uint8_t *vram, uint32_t *pixels, int line) {
+    const uint8_t *bytes = vram + line * VIDEO_LINE_BYTES;
+    const __m256i black = _mm256_set1_epi32((int) VIDEO_BLACK);
+    uint8_t *row = (uint8_t *) (pixels + (VIDEO_HEIGHT - 1) * VIDEO_WIDTH + line);
+    for (int byte = 0; byte < VIDEO_LINE_BYTES; byte++) {
+        __m256i lanes = _mm256_setr_epi32(bytes[byte], bytes[VIDEO_LINE_BYTES + byte],
+                                          bytes[2 * VIDEO_LINE_BYTES + byte], bytes[3 * VIDEO_LINE_BYTES + byte],
+                                          bytes[4 * VIDEO_LINE_BYTES + byte], bytes[5 * VIDEO_LINE_BYTES + byte],
+                                          bytes[6 * VIDEO_LINE_BYTES + byte], bytes[7 * VIDEO_LINE_BYTES + byte]);
+        for (int bit = 0; bit < 8; bit++, row -= ROW_BYTES) {
+            __m256i mask = _mm256_set1_epi32(1 << bit);
+            __m256i set = _mm256_cmpeq_epi32(_mm256_and_si256(lanes, mask), mask);
+            _mm256_store_si256((__m256i *) row, _mm256_or_si256(set, black));
+        }
+    }
+}
+
+#endif
+
+VideoKernel videoBestKernel(void) {
+#if VIDEO_X86
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2")) {
+        return VIDEO_KERNEL_AVX2;
+    }
+    if (__builtin_cpu_supports("sse2")) {
+        return VIDEO_KERNEL_SSE2;
+    }
+#endif
+    return VIDEO_KERNEL_SCALAR;
+}
+
+const char *videoKernelName(VideoKernel kernel) {
+    switch (kernel) {
+        case VIDEO_KERNEL_SSE2:
+            return "sse2";
+        case VIDEO_KERNEL_AVX2:
+            return "avx2";
+        default:
+            return "scalar";
+    }
+}
+
+int videoInit(Video *video, Cpu *cpu, VideoKernel kernel) {
+    memset(video, 0, sizeof(*video));
+    video->cpu = cpu;
+    video->kernel = VIDEO_X86 ? kernel : VIDEO_KERNEL_SCALAR;
+    // The kernels store whole rows of a group at once, which needs 32 byte alignment
+    video->pixels = aligned_alloc(32, VIDEO_WIDTH * VIDEO_HEIGHT * sizeof(uint32_t));
+    if (video->pixels == NULL) {
+        fprintf(stderr, "Cannot allocate the framebuffer\n");
+        return -1;
+    }
+    video->watcherBit = cpuAddWriteWatcher(cpu, markDirty, video);
+    if (video->watcherBit == 0) {
+        fprintf(stderr, "No write watcher left to track the video RAM\n");
+        free(video->pixels);
+        return -1;
+    }
+    for (int page = VIDEO_ADDRESS >> CPU_PAGE_SHIFT; page < (VIDEO_ADDRESS + VIDEO_SIZE) >> CPU_PAGE_SHIFT; page++) {
+        cpu->watchedPages[page] |= video->watcherBit;
+    }
+    videoInvalidate(video);
+    return 0;
+}
+
+void videoFree(Video *video) {
+    cpuRemoveWriteWatcher(video->cpu, video->watcherBit);
+    free(video->pixels);
+    video->pixels = NULL;
+}
+
+void videoInvalidate(Video *video) {
+    memset(video->dirtyLines, 1, sizeof(video->dirtyLines));
+}
+
+int videoUpdate(Video *video) {
+    const uint8_t *vram = video->cpu->memory + VIDEO_ADDRESS;
+    int group = groupLines[video->kernel];
+    int converted = 0;
+    for (int line = 0; line < VIDEO_LINES; line += group) {
+        int dirty = 0;
+        for (int i = 0; i < group; i++) {
+            dirty |= video->dirtyLines[line + i];
+            video->dirtyLines[line + i] = 0;
+        }
+        if (!dirty) {
+            continue;
+        }
+
+        switch (video->kernel) {
+#if VIDEO_X86
+            case VIDEO_KERNEL_SSE2:
+                convertSse2(vram, video->pixels, line);
+                break;
+            case VIDEO_KERNEL_AVX2:
+                convertAvx2(vram, video->pixels, line);
+                break;
+#endif
+            default:
+                convertScalar(vram, video->pixels, line);
+        }
+        converted += group;
+    }
+    video->updates++;
+    video->convertedLines += (uint64_t) converted;
+    return converted;
+}
+
+int videoWritePpm(const Video *video, const char *fileName) {
+    FILE *file = fopen(fileName, "wb");
+    if (file == NULL) {
+        fprintf(stderr, "Cannot create %s: %s\n", fileName, strerror(errno));
+        return -1;
+    }
+
+    // One row at a time, the alpha bytes dropped
+    uint8_t rgb[VIDEO_WIDTH * 3];
+    const uint8_t *pixel = (const uint8_t *) video->pixels;
+    int failed = fprintf(file, "P6\n%d %d\n255\n", VIDEO_WIDTH, VIDEO_HEIGHT) < 0;
+    for (int y = 0; y < VIDEO_HEIGHT && !failed; y++) {
+        for (int x = 0; x < VIDEO_WIDTH; x++, pixel += 4) {
+            memcpy(rgb + x * 3, pixel, 3);
+        }
+        failed = fwrite(rgb, sizeof(rgb), 1, file) != 1;
+    }
+    if (fclose(file) != 0 || failed) {
+        fprintf(stderr, "Cannot write %s\n", fileName);
+        return -1;
+    }
+    return 0;
+}
+
+#pragma clang diagnostic pop
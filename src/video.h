@@ -0,0 +1,59 @@
+#ifndef VIDEO_H
+#define VIDEO_H
+
+#include <stdint.h>
+
+#include "cpu.h"
+
+// The 1 bit per pixel video RAM holds 224 lines of 256 pixels, the least significant bit of a byte first. The
+// monitor is mounted rotated by 90 degrees, line 0 is the left column of the picture and pixel 0 its bottom.
+#define VIDEO_ADDRESS 0x2400
+#define VIDEO_LINES 224
+#define VIDEO_LINE_BYTES 32
+
+#define VIDEO_WIDTH VIDEO_LINES
+#define VIDEO_HEIGHT (VIDEO_LINE_BYTES * 8)
+
+// Pixels are stored as R, G, B, A bytes, these are their values read as a little endian uint32_t
+#define VIDEO_WHITE 0xFFFFFFFF
+#define VIDEO_BLACK 0xFF000000
+
+typedef enum {
+    VIDEO_KERNEL_SCALAR,
+    VIDEO_KERNEL_SSE2, // 4 lines at a time
+    VIDEO_KERNEL_AVX2  // 8 lines at a time
+} VideoKernel;
+
+// Keeps an RGBA picture of the video RAM up to date. A write watcher marks the lines the CPU writes to, and only
+// the groups of adjacent lines holding a dirty line are converted again.
+typedef struct {
+    Cpu *cpu;
+    int watcherBit;
+    VideoKernel kernel;
+    uint8_t dirtyLines[VIDEO_LINES];
+    // VIDEO_WIDTH x VIDEO_HEIGHT pixels, row by row from the top
+    uint32_t *pixels;
+    uint64_t updates;
+    uint64_t convertedLines;
+} Video;
+
+// Picks the fastest kernel the host supports
+VideoKernel videoBestKernel(void);
+
+const char *videoKernelName(VideoKernel kernel);
+
+// Returns 0 on success, -1 on failure. Every line starts dirty.
+int videoInit(Video *video, Cpu *cpu, VideoKernel kernel);
+
+void videoFree(Video *video);
+
+// Marks every line dirty, e.g. after memory was written other than by executing instructions
+void videoInvalidate(Video *video);
+
+// Converts the dirty lines into pixels. Returns the number of lines converted.
+int videoUpdate(Video *video);
+
+// Writes the picture as a binary PPM. Returns 0 on success, -1 on failure.
+int videoWritePpm(const Video *video, const char *fileName);
+
+#endif
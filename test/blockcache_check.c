@@ -0,0 +1,144 @@
+// Checks the block cache against the interpreter. Space Invaders runs on both in lockstep through a coin, a game
+// start and some play with the full state compared after every frame, then the undocumented aliases of JMP, CALL and
+// RET run on both, and random programs run in small cycle budgets, so that blocks are cut short, overwrite themselves
+// and each other.
+// USAGE: blockcache_check MANIFEST [SECONDS] (e.g. rom/spaceinvaders/manifest)
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "check.h"
+#include "../src/blockcache.h"
+#include "../src/invaders.h"
+
+#define RANDOM_PROGRAMS 2000
+
+static uint64_t runBlockCache(void *context, uint64_t cycles) {
+    return blockCacheRun(context, cycles);
+}
+
+static int checkGame(const char *manifest, int seconds) {
+    static SpaceInvaders interpreter, cached;
+    invadersInit(&interpreter);
+    invadersInit(&cached);
+    if (loadRomSet(manifest, interpreter.machine.memory) < 0 || loadRomSet(manifest, cached.machine.memory) < 0) {
+        return -1;
+    }
+    BlockCache cache;
+    if (blockCacheInit(&cache, &cached.machine.cpu) < 0) {
+        fprintf(stderr, "Failed to allocate the block cache\n");
+        return -1;
+    }
+    machineSetRunner(&cached.machine, runBlockCache, &cache);
+
+    int status = 0;
+    for (int frame = 0; frame < seconds * INVADERS_FRAME_RATE; frame++) {
+        interpreter.inputs[0] = cached.inputs[0] = invadersScriptedInputs((uint64_t) frame, 1);
+        machineRunFrame(&interpreter.machine);
+        machineRunFrame(&cached.machine);
+        if (!checkSameState(&interpreter.machine.cpu, &cached.machine.cpu)) {
+            fprintf(stderr, "Space Invaders diverged in frame %d\n", frame);
+            checkPrintState("interpreter", &interpreter.machine.cpu);
+            checkPrintState("blockcache", &cached.machine.cpu);
+            status = -1;
+            break;
+        }
+    }
+    printf("%llu lookups, %llu hits, %llu invalidations\n", (unsigned long long) cache.lookups,
+           (unsigned long long) cache.hits, (unsigned long long) cache.invalidations);
+    blockCacheFree(&cache);
+    return status;
+}
+
+// Runs a program of its own at 0000 on both, returns -1 if they end in different states
+static int checkProgram(const char *name, const uint8_t *program, size_t size, uint64_t cycles) {
+    static uint8_t interpreterMemory[MEMORY_SIZE], cacheMemory[MEMORY_SIZE];
+    memset(interpreterMemory, 0, MEMORY_SIZE);
+    memcpy(interpreterMemory, program, size);
+    memcpy(cacheMemory, interpreterMemory, MEMORY_SIZE);
+    Cpu interpreterCpu, cacheCpu;
+    cpuInit(&interpreterCpu, interpreterMemory);
+    cpuInit(&cacheCpu, cacheMemory);
+    interpreterCpu.sp = cacheCpu.sp = 0xF000;
+    BlockCache cache;
+    if (blockCacheInit(&cache, &cacheCpu) < 0) {
+        fprintf(stderr, "Failed to allocate the block cache\n");
+        return -1;
+    }
+    cpuRun(&interpreterCpu, cycles);
+    blockCacheRun(&cache, cycles);
+    blockCacheFree(&cache);
+    if (!checkSameState(&interpreterCpu, &cacheCpu)) {
+        fprintf(stderr, "The %s program diverged\n", name);
+        checkPrintState("interpreter", &interpreterCpu);
+        checkPrintState("blockcache", &cacheCpu);
+        return -1;
+    }
+    return 0;
+}
+
+static int checkAliases(void) {
+    // JMP 1000 through CB. CALL 000A and 000B through DD and ED which return through D9, then CALL 1000 through FD.
+    // Both end in the HLT at 1000.
+    static const uint8_t jump[] = {0xCB, 0x00, 0x10};
+    static const uint8_t calls[] = {0xDD, 0x0A, 0x00, 0xED, 0x0B, 0x00, 0xFD, 0x00, 0x10, 0x00, 0xD9, 0xD9};
+    uint8_t program[0x1001];
+    memset(program, 0, sizeof(program));
+    memcpy(program, jump, sizeof(jump));
+    program[0x1000] = 0x76;
+    if (checkProgram("CB jump", program, sizeof(program), 100) < 0) {
+        return -1;
+    }
+    memset(program, 0, sizeof(program));
+    memcpy(program, calls, sizeof(calls));
+    program[0x1000] = 0x76;
+    return checkProgram("DD, ED, FD call and D9 return", program, sizeof(program), 200);
+}
+
+static int checkRandomPrograms(void) {
+    static uint8_t interpreterMemory[MEMORY_SIZE], cacheMemory[MEMORY_SIZE];
+    srand(CHECK_RANDOM_SEED);
+    for (int program = 0; program < RANDOM_PROGRAMS; program++) {
+        Cpu interpreterCpu, cacheCpu;
+        BlockCache cache;
+        checkRandomProgram(&interpreterCpu, interpreterMemory);
+        memcpy(cacheMemory, interpreterMemory, MEMORY_SIZE);
+        cacheCpu = interpreterCpu;
+        cacheCpu.memory = cacheMemory;
+        if (blockCacheInit(&cache, &cacheCpu) < 0) {
+            fprintf(stderr, "Failed to allocate the block cache\n");
+            return -1;
+        }
+
+        for (int run = 0; run < CHECK_RANDOM_RUNS && !interpreterCpu.halted; run++) {
+            uint64_t cycles = checkRandomCycles();
+            cpuRun(&interpreterCpu, cycles);
+            blockCacheRun(&cache, cycles);
+            if (!checkSameState(&interpreterCpu, &cacheCpu)) {
+                fprintf(stderr, "Random program %d diverged in run %d\n", program, run);
+                checkPrintState("interpreter", &interpreterCpu);
+                checkPrintState("blockcache", &cacheCpu);
+                blockCacheFree(&cache);
+                return -1;
+            }
+        }
+        blockCacheFree(&cache);
+    }
+    return 0;
+}
+
+int main(int argc, char **argv) {
+    if (argc < 2) {
+        fprintf(stderr, "USAGE: blockcache_check MANIFEST [SECONDS]\n");
+        return 1;
+    }
+    int seconds = argc > 2 ? atoi(argv[2]) : 30;
+
+    if (checkGame(argv[1], seconds) < 0 || checkAliases() < 0 || checkRandomPrograms() < 0) {
+        return 1;
+    }
+    printf("Space Invaders, the aliased jumps and %d random programs ran the same on the interpreter and the block "
+           "cache\n", RANDOM_PROGRAMS);
+    return 0;
+}
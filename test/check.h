@@ -0,0 +1,55 @@
+#ifndef CHECK_H
+#define CHECK_H
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "../src/cpu.h"
+#include "../src/rom.h"
+
+// Whether two CPUs are in the same state down to their counters and memory. Only whether an EI has yet to take
+// effect counts, not when the last one ran.
+static inline int checkSameState(const Cpu *a, const Cpu *b) {
+    return a->cycles == b->cycles && a->instructions == b->instructions && a->pc == b->pc && a->sp == b->sp &&
+           a->flags == b->flags && a->interruptsEnabled == b->interruptsEnabled && a->halted == b->halted &&
+           (a->enableInstruction == a->instructions) == (b->enableInstruction == b->instructions) &&
+           memcmp(a->registers, b->registers, sizeof(a->registers)) == 0 &&
+           memcmp(a->memory, b->memory, MEMORY_SIZE) == 0;
+}
+
+static inline void checkPrintState(const char *name, const Cpu *cpu) {
+    fprintf(stderr, "%-12s pc=%04X sp=%04X a=%02X f=%02X b=%02X c=%02X d=%02X e=%02X h=%02X l=%02X cycles=%llu "
+                    "instructions=%llu\n", name, cpu->pc, cpu->sp, cpu->registers[REGISTER_A], cpu->flags,
+            cpu->registers[REGISTER_B], cpu->registers[REGISTER_C], cpu->registers[REGISTER_D],
+            cpu->registers[REGISTER_E], cpu->registers[REGISTER_H], cpu->registers[REGISTER_L],
+            (unsigned long long) cpu->cycles, (unsigned long long) cpu->instructions);
+}
+
+// Random programs run in up to CHECK_RANDOM_RUNS slices of up to CHECK_RANDOM_MAX_CYCLES, so that they get cut short
+// at any instruction. The sequence starts from srand(CHECK_RANDOM_SEED) so that every check runs the same programs.
+#define CHECK_RANDOM_SEED 8080
+#define CHECK_RANDOM_RUNS 64
+#define CHECK_RANDOM_MAX_CYCLES 400
+
+// Fills memory with a random program and starts the CPU on it with random registers, flags, stack pointer and
+// program counter
+static inline void checkRandomProgram(Cpu *cpu, uint8_t *memory) {
+    for (int address = 0; address < MEMORY_SIZE; address++) {
+        memory[address] = (uint8_t) rand();
+    }
+    cpuInit(cpu, memory);
+    for (int reg = 0; reg < 8; reg++) {
+        cpu->registers[reg] = (uint8_t) rand();
+    }
+    cpu->flags = (uint8_t) ((rand() & (FLAG_S | FLAG_Z | FLAG_AC | FLAG_P | FLAG_CY)) | FLAG_ALWAYS_ONE);
+    cpu->sp = (uint16_t) rand();
+    cpu->pc = (uint16_t) rand();
+}
+
+// Cycles of the next slice of a random program
+static inline uint64_t checkRandomCycles(void) {
+    return 1 + (uint64_t) rand() % CHECK_RANDOM_MAX_CYCLES;
+}
+
+#endif
@@ -0,0 +1,26 @@
+# Runs two commands and fails unless both succeed and write the same to standard output. What they write to standard
+# error is shown only when one fails.
+# USAGE: cmake -DFIRST="COMMAND [ARGUMENT...]" -DSECOND="COMMAND [ARGUMENT...]" -P compare_output.cmake
+
+function(run_command variable command)
+    separate_arguments(arguments UNIX_COMMAND "${command}")
+    execute_process(
+            COMMAND ${arguments}
+            OUTPUT_VARIABLE output
+            ERROR_VARIABLE errors
+            RESULT_VARIABLE status)
+    if(NOT status EQUAL 0)
+        message(FATAL_ERROR "${command} failed: ${status}\n${errors}")
+    endif()
+    set(${variable} "${output}" PARENT_SCOPE)
+endfunction()
+
+run_command(first "${FIRST}")
+run_command(second "${SECOND}")
+if(NOT first STREQUAL second)
+    string(LENGTH "${first}" firstLength)
+    string(LENGTH "${second}" secondLength)
+    message(FATAL_ERROR "${FIRST} and ${SECOND} wrote different output, ${firstLength} and ${secondLength} characters")
+endif()
+string(LENGTH "${first}" length)
+message(STATUS "Both wrote the same ${length} characters")
@@ -0,0 +1,75 @@
+// Plays Space Invaders through a game and runs random programs in small slices, and prints the state of the CPU
+// after every frame and every slice and a checksum of memory after every frame and every program. Built once with
+// S, Z, AC and P computed at once and once with CPU_LAZY_FLAGS, the lazy_flags test compares what both builds print.
+// USAGE: cpu_state MANIFEST [SECONDS] (e.g. rom/spaceinvaders/manifest)
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "check.h"
+#include "../src/invaders.h"
+
+#define RANDOM_PROGRAMS 500
+
+static void printState(const char *name, int index, const Cpu *cpu) {
+    printf("%s %d: pc=%04X sp=%04X a=%02X f=%02X b=%02X c=%02X d=%02X e=%02X h=%02X l=%02X ie=%d halted=%d "
+           "cycles=%llu instructions=%llu\n", name, index, cpu->pc, cpu->sp, cpu->registers[REGISTER_A], cpu->flags,
+           cpu->registers[REGISTER_B], cpu->registers[REGISTER_C], cpu->registers[REGISTER_D],
+           cpu->registers[REGISTER_E], cpu->registers[REGISTER_H], cpu->registers[REGISTER_L],
+           cpu->interruptsEnabled, cpu->halted, (unsigned long long) cpu->cycles,
+           (unsigned long long) cpu->instructions);
+}
+
+static void printMemory(const char *name, int index, const Cpu *cpu) {
+    printf("%s %d: memory=%08X\n", name, index, crc32(cpu->memory, MEMORY_SIZE));
+}
+
+static int runGame(const char *manifest, int seconds) {
+    static SpaceInvaders invaders;
+    invadersInit(&invaders);
+    if (loadRomSet(manifest, invaders.machine.memory) < 0) {
+        return -1;
+    }
+    for (int frame = 0; frame < seconds * INVADERS_FRAME_RATE; frame++) {
+        invaders.inputs[0] = invadersScriptedInputs((uint64_t) frame, 1);
+        machineRunFrame(&invaders.machine);
+        printState("frame", frame, &invaders.machine.cpu);
+        printMemory("frame", frame, &invaders.machine.cpu);
+    }
+    return 0;
+}
+
+// Every other program runs on the switch dispatch loop
+static void runRandomPrograms(void) {
+    static uint8_t memory[MEMORY_SIZE];
+    srand(CHECK_RANDOM_SEED);
+    for (int program = 0; program < RANDOM_PROGRAMS; program++) {
+        Cpu cpu;
+        checkRandomProgram(&cpu, memory);
+
+        for (int run = 0; run < CHECK_RANDOM_RUNS && !cpu.halted; run++) {
+            uint64_t cycles = checkRandomCycles();
+            if (program & 1) {
+                cpuRunSwitch(&cpu, cycles);
+            } else {
+                cpuRun(&cpu, cycles);
+            }
+            printState("program", program, &cpu);
+        }
+        printMemory("program", program, &cpu);
+    }
+}
+
+int main(int argc, char **argv) {
+    if (argc < 2) {
+        fprintf(stderr, "USAGE: cpu_state MANIFEST [SECONDS]\n");
+        return 1;
+    }
+    int seconds = argc > 2 ? atoi(argv[2]) : 30;
+
+    if (runGame(argv[1], seconds) < 0) {
+        return 1;
+    }
+    runRandomPrograms();
+    return 0;
+}
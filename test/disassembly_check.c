@@ -0,0 +1,53 @@
+// Checks that the reentrant disassembler reports truncated code and full buffers instead of reading or writing past
+// them, for every opcode.
+// USAGE: disassembly_check
+
+#include <stdio.h>
+#include <string.h>
+
+#include "../src/disassembly.h"
+
+// Formats every opcode with every buffer size up to the one it needs, and decodes it cut off at every byte
+static int verifyText(void) {
+    int failures = 0;
+    for (int opCode = 0; opCode < 256; opCode++) {
+        uint8_t code[3] = {(uint8_t) opCode, 0xA5, 0x5A};
+        Instruction instruction;
+        int length = disassembleOne(code, sizeof(code), 0, &instruction);
+        char expected[DISASSEMBLY_TEXT_SIZE];
+        int textLength = formatInstructionText(expected, sizeof(expected), 0xFFFF, &instruction);
+        for (size_t size = 0; size < (size_t) length; size++) {
+            if (disassembleOne(code, size, 0, &instruction) != DISASSEMBLY_TRUNCATED) {
+                fprintf(stderr, "%02X cut off after %zu bytes isn't truncated\n", opCode, size);
+                failures++;
+            }
+        }
+
+        // One byte more than the text fits, the rest of the buffer has to stay untouched
+        for (size_t capacity = 0; capacity <= (size_t) textLength + 1; capacity++) {
+            char text[DISASSEMBLY_TEXT_SIZE + 1];
+            memset(text, '~', sizeof(text));
+            int result = formatInstructionText(text, capacity, 0xFFFF, &instruction);
+            int fits = capacity > (size_t) textLength;
+            if (fits ? result != textLength || strcmp(text, expected) != 0 : result != DISASSEMBLY_NO_ROOM) {
+                fprintf(stderr, "%02X formatted into %zu bytes returned %d\n", opCode, capacity, result);
+                failures++;
+            }
+            if (text[capacity] != '~') {
+                fprintf(stderr, "%02X formatted into %zu bytes wrote past them\n", opCode, capacity);
+                failures++;
+            }
+        }
+    }
+    return failures;
+}
+
+int main(void) {
+    int failures = verifyText();
+    if (failures != 0) {
+        fprintf(stderr, "%d disassembler calls went wrong\n", failures);
+        return 1;
+    }
+    printf("every opcode is reported truncated and formatted into every buffer size correctly\n");
+    return 0;
+}
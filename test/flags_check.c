@@ -0,0 +1,73 @@
+#pragma clang diagnostic push
+#pragma ide diagnostic ignored "hicpp-signed-bitwise"
+
+// Checks the table driven flags of lazyFlags(), which the CPU computes at once or, with CPU_LAZY_FLAGS, when they are
+// read, against a bitwise reference for every operand pair and carry of every instruction setting them.
+// USAGE: flags_check
+
+#include <stdio.h>
+
+#include "flags_reference.h"
+#include "../src/flags.h"
+
+static int verify(void) {
+    int failures = 0;
+    for (int operand = 0; operand < 256; operand++) {
+        uint8_t result = (uint8_t) (operand + 1);
+        uint8_t expected = referenceSignZeroParity(result) | ((result & 0x0F) == 0 ? FLAG_AC : 0);
+        if (lazyFlags(LAZY_ADD, (uint8_t) operand, 1, result) != expected) {
+            fprintf(stderr, "INR %02X\n", operand);
+            failures++;
+        }
+        result = (uint8_t) (operand - 1);
+        expected = referenceSignZeroParity(result) | ((result & 0x0F) != 0x0F ? FLAG_AC : 0);
+        if (lazyFlags(LAZY_SUBTRACT, (uint8_t) operand, 1, result) != expected) {
+            fprintf(stderr, "DCR %02X\n", operand);
+            failures++;
+        }
+
+        for (int value = 0; value < 256; value++) {
+            result = (uint8_t) (operand & value);
+            expected = referenceSignZeroParity(result) | ((operand & 0x08) || (value & 0x08) ? FLAG_AC : 0);
+            if (lazyFlags(LAZY_AND, (uint8_t) operand, (uint8_t) value, result) != expected) {
+                fprintf(stderr, "ANA %02X,%02X\n", operand, value);
+                failures++;
+            }
+            result = (uint8_t) (operand | value);
+            if (lazyFlags(LAZY_AND, 0, 0, result) != referenceSignZeroParity(result)) {
+                fprintf(stderr, "ORA %02X,%02X\n", operand, value);
+                failures++;
+            }
+
+            for (int carry = 0; carry <= 1; carry++) {
+                result = (uint8_t) (operand + value + carry);
+                expected = referenceAdditionFlags((uint8_t) operand, (uint8_t) value, carry);
+                if ((lazyFlags(LAZY_ADD, (uint8_t) operand, (uint8_t) value, result) |
+                     (operand + value + carry > 0xFF ? FLAG_CY : 0)) != expected) {
+                    fprintf(stderr, "ADD %02X,%02X,%d\n", operand, value, carry);
+                    failures++;
+                }
+                result = (uint8_t) (operand - value - carry);
+                expected = referenceSubtractionFlags((uint8_t) operand, (uint8_t) value, carry);
+                if ((lazyFlags(LAZY_SUBTRACT, (uint8_t) operand, (uint8_t) value, result) |
+                     (operand - value - carry < 0 ? FLAG_CY : 0)) != expected) {
+                    fprintf(stderr, "SUB %02X,%02X,%d\n", operand, value, carry);
+                    failures++;
+                }
+            }
+        }
+    }
+    return failures;
+}
+
+int main(void) {
+    int failures = verify();
+    if (failures != 0) {
+        fprintf(stderr, "%d flag computations differ from the reference\n", failures);
+        return 1;
+    }
+    printf("all operand pairs match the reference\n");
+    return 0;
+}
+
+#pragma clang diagnostic pop
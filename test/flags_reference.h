@@ -0,0 +1,30 @@
+#ifndef FLAGS_REFERENCE_H
+#define FLAGS_REFERENCE_H
+
+#include <stdint.h>
+
+#include "../src/cpu.h"
+
+// The flags computed bit by bit as the 8080 data book describes them
+
+static inline uint8_t referenceSignZeroParity(uint8_t result) {
+    int ones = 0;
+    for (int bit = 0; bit < 8; bit++) {
+        ones += (result >> bit) & 1;
+    }
+    return (result & FLAG_S) | (result == 0 ? FLAG_Z : 0) | ((ones & 1) ? 0 : FLAG_P) | FLAG_ALWAYS_ONE;
+}
+
+static inline uint8_t referenceAdditionFlags(uint8_t operand, uint8_t value, int carry) {
+    unsigned int result = operand + value + carry;
+    int auxCarry = (operand & 0x0F) + (value & 0x0F) + carry > 0x0F;
+    return referenceSignZeroParity((uint8_t) result) | (auxCarry ? FLAG_AC : 0) | (result > 0xFF ? FLAG_CY : 0);
+}
+
+static inline uint8_t referenceSubtractionFlags(uint8_t operand, uint8_t value, int borrow) {
+    int result = operand - value - borrow;
+    int auxCarry = (operand & 0x0F) + (~value & 0x0F) + !borrow > 0x0F;
+    return referenceSignZeroParity((uint8_t) result) | (auxCarry ? FLAG_AC : 0) | (result < 0 ? FLAG_CY : 0);
+}
+
+#endif
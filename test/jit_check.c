@@ -0,0 +1,102 @@
+// Checks the JIT against the interpreter. Space Invaders runs on both in lockstep through a coin, a game start and
+// some play with the full state compared after every frame, and random programs run with every block translated on
+// first use and small cycle budgets, so that blocks are cut short, overwrite themselves and each other.
+// USAGE: jit_check MANIFEST [SECONDS] (e.g. rom/spaceinvaders/manifest)
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "check.h"
+#include "../src/invaders.h"
+#include "../src/jit.h"
+
+#define RANDOM_PROGRAMS 2000
+
+static uint64_t runJit(void *context, uint64_t cycles) {
+    return jitRun(context, cycles);
+}
+
+static int checkGame(const char *manifest, int seconds) {
+    static SpaceInvaders interpreter, jitted;
+    invadersInit(&interpreter);
+    invadersInit(&jitted);
+    if (loadRomSet(manifest, interpreter.machine.memory) < 0 || loadRomSet(manifest, jitted.machine.memory) < 0) {
+        return -1;
+    }
+    Jit jit;
+    if (jitInit(&jit, &jitted.machine.cpu) < 0) {
+        fprintf(stderr, "Failed to allocate the JIT\n");
+        return -1;
+    }
+    machineSetRunner(&jitted.machine, runJit, &jit);
+
+    int status = 0;
+    for (int frame = 0; frame < seconds * INVADERS_FRAME_RATE; frame++) {
+        interpreter.inputs[0] = jitted.inputs[0] = invadersScriptedInputs((uint64_t) frame, 1);
+        machineRunFrame(&interpreter.machine);
+        machineRunFrame(&jitted.machine);
+        if (!checkSameState(&interpreter.machine.cpu, &jitted.machine.cpu)) {
+            fprintf(stderr, "Space Invaders diverged in frame %d\n", frame);
+            checkPrintState("interpreter", &interpreter.machine.cpu);
+            checkPrintState("jit", &jitted.machine.cpu);
+            status = -1;
+            break;
+        }
+    }
+    printf("%llu blocks translated, %llu native runs, %llu invalidations, %llu flushes\n",
+           (unsigned long long) jit.translations, (unsigned long long) jit.nativeRuns,
+           (unsigned long long) jit.invalidations, (unsigned long long) jit.flushes);
+    jitFree(&jit);
+    return status;
+}
+
+static int checkRandomPrograms(void) {
+    static uint8_t interpreterMemory[MEMORY_SIZE], jitMemory[MEMORY_SIZE];
+    srand(CHECK_RANDOM_SEED);
+    for (int program = 0; program < RANDOM_PROGRAMS; program++) {
+        Cpu interpreterCpu, jitCpu;
+        Jit jit;
+        checkRandomProgram(&interpreterCpu, interpreterMemory);
+        memcpy(jitMemory, interpreterMemory, MEMORY_SIZE);
+        jitCpu = interpreterCpu;
+        jitCpu.memory = jitMemory;
+        if (jitInit(&jit, &jitCpu) < 0) {
+            fprintf(stderr, "Failed to allocate the JIT\n");
+            return -1;
+        }
+        jit.hotThreshold = 1;
+
+        for (int run = 0; run < CHECK_RANDOM_RUNS && !interpreterCpu.halted; run++) {
+            uint64_t cycles = checkRandomCycles();
+            cpuRun(&interpreterCpu, cycles);
+            jitRun(&jit, cycles);
+            if (!checkSameState(&interpreterCpu, &jitCpu)) {
+                fprintf(stderr, "Random program %d diverged in run %d\n", program, run);
+                checkPrintState("interpreter", &interpreterCpu);
+                checkPrintState("jit", &jitCpu);
+                jitFree(&jit);
+                return -1;
+            }
+        }
+        jitFree(&jit);
+    }
+    return 0;
+}
+
+int main(int argc, char **argv) {
+    if (argc < 2) {
+        fprintf(stderr, "USAGE: jit_check MANIFEST [SECONDS]\n");
+        return 1;
+    }
+    int seconds = argc > 2 ? atoi(argv[2]) : 30;
+
+    if (!JIT_NATIVE) {
+        printf("No native code generation on this platform, the JIT only interprets\n");
+    }
+    if (checkGame(argv[1], seconds) < 0 || checkRandomPrograms() < 0) {
+        return 1;
+    }
+    printf("Space Invaders and %d random programs ran the same on the interpreter and the JIT\n", RANDOM_PROGRAMS);
+    return 0;
+}
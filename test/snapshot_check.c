@@ -0,0 +1,115 @@
+// Boots Space Invaders to its attract mode, snapshots it and forks one-frame branches from that snapshot. Checks
+// every branch ends in the same state as a board which ran on without snapshots, that the video watching the board
+// redraws what every restore copied, and that a branch saved as a delta against the fork point loads in that state
+// again.
+// USAGE: snapshot_check MANIFEST SNAPSHOT_FILE [BRANCHES] (e.g. rom/spaceinvaders/manifest /tmp/invaders.snapshot)
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "check.h"
+#include "../src/invaders.h"
+#include "../src/snapshot.h"
+#include "../src/video.h"
+
+// By then the attract mode draws on the screen every frame, so every branch writes the video RAM
+#define BOOT_SECONDS 12
+
+// A snapshot holds the CPU and its memory, the frame timeline and the shift register of the board are copied from the
+// board the snapshot was taken of
+static void restoreBoard(SnapshotTracker *tracker, Snapshot *snapshot, SpaceInvaders *board,
+                         const SpaceInvaders *from) {
+    snapshotRestore(tracker, snapshot);
+    board->machine.frameStart = from->machine.frameStart;
+    board->shiftRegister = from->shiftRegister;
+    board->shiftOffset = from->shiftOffset;
+}
+
+int main(int argc, char **argv) {
+    if (argc < 3) {
+        fprintf(stderr, "USAGE: snapshot_check MANIFEST SNAPSHOT_FILE [BRANCHES]\n");
+        return 1;
+    }
+    int branches = argc > 3 ? atoi(argv[3]) : 1000;
+
+    static SpaceInvaders board, reference, forkBoard;
+    invadersInit(&board);
+    invadersInit(&reference);
+    if (loadRomSet(argv[1], board.machine.memory) < 0 || loadRomSet(argv[1], reference.machine.memory) < 0) {
+        return 1;
+    }
+    SnapshotTracker tracker;
+    if (snapshotTrackerInit(&tracker, &board.machine.cpu) != 0) {
+        return 1;
+    }
+    // The incremental picture only stays right if restores reach the video watcher
+    Video video, referenceVideo;
+    if (videoInit(&video, &board.machine.cpu, VIDEO_KERNEL_SCALAR) != 0 ||
+        videoInit(&referenceVideo, &board.machine.cpu, VIDEO_KERNEL_SCALAR) != 0) {
+        return 1;
+    }
+    machineRunFrames(&board.machine, BOOT_SECONDS * INVADERS_FRAME_RATE);
+    machineRunFrames(&reference.machine, BOOT_SECONDS * INVADERS_FRAME_RATE + 1);
+    Snapshot *forkSnapshot = snapshotTake(&tracker);
+    if (forkSnapshot == NULL) {
+        return 1;
+    }
+    forkBoard = board;
+
+    Snapshot *branch = NULL;
+    for (int i = 0; i < branches; i++) {
+        restoreBoard(&tracker, forkSnapshot, &board, &forkBoard);
+        videoUpdate(&video);
+        videoInvalidate(&referenceVideo);
+        videoUpdate(&referenceVideo);
+        if (memcmp(video.pixels, referenceVideo.pixels, VIDEO_WIDTH * VIDEO_HEIGHT * sizeof(uint32_t)) != 0) {
+            fprintf(stderr, "The video missed memory restored for branch %d\n", i);
+            return 1;
+        }
+        machineRunFrame(&board.machine);
+        videoUpdate(&video);
+        if (!checkSameState(&board.machine.cpu, &reference.machine.cpu)) {
+            fprintf(stderr, "Branch %d ended in a different state\n", i);
+            checkPrintState("branch", &board.machine.cpu);
+            checkPrintState("reference", &reference.machine.cpu);
+            return 1;
+        }
+        snapshotRelease(branch);
+        branch = snapshotTake(&tracker);
+        if (branch == NULL) {
+            return 1;
+        }
+    }
+    printf("%d branches of one frame ended in the same state\n", branches);
+
+    char deltaName[4096];
+    snprintf(deltaName, sizeof(deltaName), "%s.delta", argv[2]);
+    if (snapshotSave(forkSnapshot, NULL, argv[2]) != 0 || snapshotSave(branch, forkSnapshot, deltaName) != 0) {
+        return 1;
+    }
+    Snapshot *loadedFork = snapshotLoad(NULL, argv[2]);
+    Snapshot *loadedBranch = loadedFork != NULL ? snapshotLoad(loadedFork, deltaName) : NULL;
+    remove(argv[2]);
+    remove(deltaName);
+    if (loadedBranch == NULL) {
+        return 1;
+    }
+    restoreBoard(&tracker, loadedBranch, &board, &reference);
+    if (!checkSameState(&board.machine.cpu, &reference.machine.cpu)) {
+        fprintf(stderr, "The saved branch loaded in a different state\n");
+        checkPrintState("loaded", &board.machine.cpu);
+        checkPrintState("reference", &reference.machine.cpu);
+        return 1;
+    }
+    printf("the saved branch loaded in the same state\n");
+
+    snapshotRelease(forkSnapshot);
+    snapshotRelease(branch);
+    snapshotRelease(loadedFork);
+    snapshotRelease(loadedBranch);
+    snapshotTrackerFree(&tracker);
+    videoFree(&video);
+    videoFree(&referenceVideo);
+    return 0;
+}
@@ -0,0 +1,74 @@
+// Plays the first seconds of a Space Invaders game and converts the video RAM after every frame with each kernel,
+// once incrementally from the dirty lines and once in full. Checks every picture matches a full scalar conversion.
+// USAGE: video_check MANIFEST [SECONDS] (e.g. rom/spaceinvaders/manifest)
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "../src/invaders.h"
+#include "../src/video.h"
+
+#define KERNEL_COUNT 3
+
+int main(int argc, char **argv) {
+    if (argc < 2) {
+        fprintf(stderr, "USAGE: video_check MANIFEST [SECONDS]\n");
+        return 1;
+    }
+    int seconds = argc > 2 ? atoi(argv[2]) : 30;
+
+    static SpaceInvaders invaders;
+    invadersInit(&invaders);
+    Machine *machine = &invaders.machine;
+    if (loadRomSet(argv[1], machine->memory) < 0) {
+        return 1;
+    }
+
+    Video incremental[KERNEL_COUNT];
+    Video full[KERNEL_COUNT];
+    Video reference;
+    int kernelCount = (int) videoBestKernel() + 1;
+    for (int kernel = 0; kernel < kernelCount; kernel++) {
+        if (videoInit(&incremental[kernel], &machine->cpu, (VideoKernel) kernel) != 0 ||
+            videoInit(&full[kernel], &machine->cpu, (VideoKernel) kernel) != 0) {
+            return 1;
+        }
+    }
+    if (videoInit(&reference, &machine->cpu, VIDEO_KERNEL_SCALAR) != 0) {
+        return 1;
+    }
+
+    int status = 0;
+    int frames = seconds * INVADERS_FRAME_RATE;
+    for (int frame = 0; frame < frames && status == 0; frame++) {
+        invaders.inputs[0] = invadersScriptedInputs((uint64_t) frame, 0);
+        machineRunFrame(machine);
+
+        videoInvalidate(&reference);
+        videoUpdate(&reference);
+        for (int kernel = 0; kernel < kernelCount; kernel++) {
+            videoUpdate(&incremental[kernel]);
+            videoInvalidate(&full[kernel]);
+            videoUpdate(&full[kernel]);
+
+            size_t size = VIDEO_WIDTH * VIDEO_HEIGHT * sizeof(uint32_t);
+            if (memcmp(incremental[kernel].pixels, reference.pixels, size) != 0 ||
+                memcmp(full[kernel].pixels, reference.pixels, size) != 0) {
+                fprintf(stderr, "The %s kernel differs from the reference at frame %d\n",
+                        videoKernelName((VideoKernel) kernel), frame);
+                status = 1;
+            }
+        }
+    }
+    if (status == 0) {
+        printf("%d frames on %d kernels, all pictures match\n", frames, kernelCount);
+    }
+
+    for (int kernel = 0; kernel < kernelCount; kernel++) {
+        videoFree(&incremental[kernel]);
+        videoFree(&full[kernel]);
+    }
+    videoFree(&reference);
+    return status;
+}